@@ -0,0 +1,184 @@
+// clox-basic - C Language Implementation of jlox from Crafting Interpreters.
+//
+// Copyright (C) 2022 Amritpal Singh
+//
+// This file is part of clox-basic.
+//
+// clox-basic is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3
+// of the License, or (at your option) any later version.
+//
+// clox-basic is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied
+// warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// clox-basic. If not, see <https://www.gnu.org/licenses/>.
+
+/* evaluator throughput benchmark, parses generated scripts once and runs
+ * them with interpret() and with the compiled chunk on the virtual machine
+ * several times. Reports the binary expressions of arithmetic on variables
+ * evaluated per second, and how fast a long string is built piece by piece
+ * with + */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../src/arena.h"
+#include "../src/chunk.h"
+#include "../src/compiler.h"
+#include "../src/environment.h"
+#include "../src/evaluator.h"
+#include "../src/expr_pool.h"
+#include "../src/parser.h"
+#include "../src/program.h"
+#include "../src/resolver.h"
+#include "../src/scanner.h"
+#include "../src/utility.h"
+#include "../src/vm.h"
+
+enum { ROUNDS = 20, GENERATED_LINES = 100000, PIECES = 20000 };
+
+static const char* arithmetic_prologue = "var a = 3; var b = 1.5; var c = 7;\n";
+
+/* the operands are variables so none of it is folded away */
+static const char* arithmetic_sample =
+  "a * b + c - a / b % c;\n"
+  "{ var d = a + b * c; d + d - a; }\n";
+
+/* the last line compares equal lengths, so the characters are needed */
+static const char* concatenation_prologue = "var s = \"\";\n";
+static const char* concatenation_sample =
+  "var s = s + \"a line of the report, forty bytes long\\n\";\n";
+static const char* concatenation_epilogue = "s == s + \"\";\n";
+
+static double
+seconds(void)
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* a script of the sample repeated 'lines' times between the prologue
+ * and the epilogue */
+static Source_file
+generate(const char* prologue,
+         const char* sample,
+         const char* epilogue,
+         size_t lines)
+{
+    size_t prologue_len = strlen(prologue);
+    size_t sample_len = strlen(sample);
+    size_t epilogue_len = strlen(epilogue);
+    Source_file file = { .size = prologue_len + sample_len * lines + epilogue_len };
+    char* buffer = malloc(file.size + 1);
+
+    memcpy(buffer, prologue, prologue_len);
+    for (size_t i = 0; i < lines; i++)
+        memcpy(buffer + prologue_len + i * sample_len, sample, sample_len);
+    memcpy(buffer + prologue_len + sample_len * lines, epilogue, epilogue_len);
+
+    buffer[file.size] = '\0';
+    file.data = buffer;
+    return file;
+}
+
+/* parse and resolve a script, then run it ROUNDS times
+ * Params:
+ * @file : the script
+ * @bytecode : run it on the virtual machine, compiled once beforehand
+ * @binaries : the number of binary expressions in the script
+ * Ret:
+ * @double : the best time of a run in seconds
+ */
+static double
+bench_script(Source_file file, bool bytecode, size_t* binaries)
+{
+    Env_manager env_mgr = init_env_manager();
+    Scanner scanner = init_scanner(file.data, file.size);
+    Parser parser = { 0 };
+    Program program = { .env_mgr = &env_mgr,
+                        .parser = &parser,
+                        .scanner = &scanner };
+
+    set_error_source(file.data, file.size);
+    scanner.strings = &program.strings;
+    parser = init_parser(&scanner, &program.ast, &program.exprs);
+    program.statements = parse(&program);
+    deallocate_tokens(scanner.tokens);
+
+    if (program.statements == NULL || !resolve(&program)) {
+        fprintf(stderr, "the generated script does not parse\n");
+        exit(EXIT_FAILURE);
+    }
+
+    *binaries = 0;
+    for (size_t i = 0; i < program.exprs.count; i++)
+        *binaries += program.exprs.nodes[i].type == BINARY;
+
+    Chunk chunk = init_chunk();
+    if (bytecode) {
+        compile(&program, &chunk);
+        reserve_globals(&env_mgr, hmlenu(program.globals));
+    }
+
+    double best = 0;
+    for (size_t r = 0; r < ROUNDS; r++) {
+        double begin = seconds();
+        if (bytecode)
+            run_chunk(&chunk, &env_mgr, &program.had_runtime_error);
+        else
+            interpret(&program);
+        double elapsed = seconds() - begin;
+
+        if (r == 0 || elapsed < best) best = elapsed;
+    }
+
+    deallocate_chunk(&chunk);
+    deallocate_env_manager(&env_mgr);
+    hmfree(program.globals);
+    deallocate_intern_table(&program.strings);
+    deallocate_arena(&program.ast);
+    deallocate_expr_pool(&program.exprs);
+    set_error_source(NULL, 0);
+    return best;
+}
+
+int
+main(void)
+{
+    static const char* backends[] = { "tree-walker", "bytecode VM" };
+    size_t binaries = 0;
+
+    Source_file file = generate(
+      arithmetic_prologue, arithmetic_sample, "", GENERATED_LINES);
+    for (int vm = 0; vm <= 1; vm++) {
+        double best = bench_script(file, vm, &binaries);
+        printf("%s: evaluated %zu binary expressions: %8.2f M evaluations/s\n",
+               backends[vm],
+               binaries,
+               binaries / best / 1e6);
+    }
+    freefile(file);
+
+    file = generate(concatenation_prologue,
+                    concatenation_sample,
+                    concatenation_epilogue,
+                    PIECES);
+    for (int vm = 0; vm <= 1; vm++) {
+        double best = bench_script(file, vm, &binaries);
+        printf("%s: built a string of %d pieces: %8.2f ms, %8.2f M pieces/s\n",
+               backends[vm],
+               PIECES,
+               best * 1e3,
+               PIECES / best / 1e6);
+    }
+    freefile(file);
+}
@@ -0,0 +1,110 @@
+// clox-basic - C Language Implementation of jlox from Crafting Interpreters.
+//
+// Copyright (C) 2022 Amritpal Singh
+//
+// This file is part of clox-basic.
+//
+// clox-basic is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3
+// of the License, or (at your option) any later version.
+//
+// clox-basic is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied
+// warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// clox-basic. If not, see <https://www.gnu.org/licenses/>.
+
+/* micro-benchmark for keyword recognition of scanned identifiers,
+ * compares get_keyword() against the strncmp chain it replaced */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../src/token.h"
+#include "../src/utility.h"
+
+enum { IDENT_CNT = 4096, ROUNDS = 2000 };
+
+extern const char* TokenTypeString[];
+
+static const char* words[] = { "x",     "count", "index", "value", "print",
+                               "var",   "total", "if",    "else",  "name",
+                               "while", "i",     "result", "true", "nil",
+                               "buffer" };
+
+/* the previous recognizer, kept here as the baseline */
+static bool
+strncmp_nl(const char* s1, const char* s2, size_t count)
+{
+    if (s1 == NULL || s2 == NULL) return false;
+    if (count == 0) return false;
+
+    while (count--) {
+        if (*s1 == '\0' || *s2 == '\0') return false;
+        if (*s1++ != *s2++) return false;
+    }
+    return true;
+}
+
+static enum TOKEN_TYPE
+get_keyword_chain(const char* str)
+{
+    static const enum TOKEN_TYPE keywords[] = { AND,   CLASS, ELSE, FALSE, FOR,
+                                                FUN,   IF,    NIL,  OR,    PRINT,
+                                                RET,   SUPER, THIS, TRUE,  VAR,
+                                                WHILE };
+
+    for_range(i, sizeof(keywords) / sizeof(keywords[0]))
+    {
+        const char* kw = TokenTypeString[keywords[i]];
+        if (strncmp_nl(str, kw, strlen(kw))) return keywords[i];
+    }
+    return IDENTIFIER;
+}
+
+static double
+seconds(void)
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int
+main(void)
+{
+    const char* idents[IDENT_CNT];
+    size_t lens[IDENT_CNT];
+    size_t checksum = 0;
+
+    srand(42);
+    for_range(i, IDENT_CNT)
+    {
+        idents[i] = words[rand() % (sizeof(words) / sizeof(words[0]))];
+        lens[i] = strlen(idents[i]);
+    }
+
+    double begin = seconds();
+    for (size_t r = 0; r < ROUNDS; r++)
+        for (size_t i = 0; i < IDENT_CNT; i++)
+            checksum += get_keyword_chain(idents[i]);
+    double chain = seconds() - begin;
+
+    begin = seconds();
+    for (size_t r = 0; r < ROUNDS; r++)
+        for (size_t i = 0; i < IDENT_CNT; i++)
+            checksum += get_keyword(idents[i], lens[i]);
+    double trie = seconds() - begin;
+
+    double total = (double)IDENT_CNT * ROUNDS / 1e6;
+    printf("strncmp chain : %8.2f M identifiers/s\n", total / chain);
+    printf("switch trie   : %8.2f M identifiers/s\n", total / trie);
+    printf("(checksum %zu)\n", checksum);
+}
@@ -0,0 +1,158 @@
+// clox-basic - C Language Implementation of jlox from Crafting Interpreters.
+//
+// Copyright (C) 2022 Amritpal Singh
+//
+// This file is part of clox-basic.
+//
+// clox-basic is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3
+// of the License, or (at your option) any later version.
+//
+// clox-basic is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied
+// warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// clox-basic. If not, see <https://www.gnu.org/licenses/>.
+
+/* scanner throughput benchmark, scans a lox script (or a generated one when
+ * no script is given) with scan_tokens() and scan_tokens_parallel() using
+ * both lexer cores and reports the token buffer stats, then times
+ * rescan_tokens() after a small edit */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../src/incremental_scanner.h"
+#include "../src/parallel_scanner.h"
+#include "../src/scanner.h"
+#include "../src/token.h"
+#include "../src/utility.h"
+
+enum { ROUNDS = 10, GENERATED_LINES = 200000 };
+
+static const char* sample =
+  "var count = 12; // running count\n"
+  "/* a block comment */ print count * 2 + 3.25;\n"
+  "if (count >= 10) { print \"large\"; } else print \"small\";\n";
+
+static double
+seconds(void)
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static char*
+generate(size_t* size)
+{
+    size_t sample_len = strlen(sample);
+    char* buffer = malloc(sample_len * GENERATED_LINES + 1);
+
+    for (size_t i = 0; i < GENERATED_LINES; i++)
+        memcpy(buffer + i * sample_len, sample, sample_len);
+
+    *size = sample_len * GENERATED_LINES;
+    buffer[*size] = '\0';
+    return buffer;
+}
+
+/* benchmark one lexer core, threads > 0 scans with scan_tokens_parallel() */
+static void
+bench_lexer(const char* name,
+            enum LEXER lexer,
+            size_t threads,
+            const char* buffer,
+            size_t size)
+{
+    Scanner scanner = { 0 };
+    double best = 0;
+
+    for (size_t r = 0; r < ROUNDS; r++) {
+        scanner = init_scanner(buffer, size);
+        scanner.lexer = lexer;
+
+        double begin = seconds();
+        if (threads > 0) scan_tokens_parallel(&scanner, threads);
+        else scan_tokens(&scanner);
+        double elapsed = seconds() - begin;
+
+        if (r == 0 || elapsed < best) best = elapsed;
+        if (r + 1 < ROUNDS) deallocate_tokens(scanner.tokens);
+    }
+
+    printf("%-6s scanned %zu tokens from %zu bytes: %8.2f MB/s\n",
+           name,
+           scanner.tokens_count + 1,
+           size,
+           size / best / 1e6);
+    printf("%-6s initial capacity %zu, peak capacity %zu, %zu reallocs\n",
+           name,
+           scanner.stats.initial_capacity,
+           scanner.stats.peak_capacity,
+           scanner.stats.reallocs);
+
+    deallocate_tokens(scanner.tokens);
+}
+
+/* time rescan_tokens() after inserting a space in the middle of the source */
+static void
+bench_rescan(const char* buffer, size_t size)
+{
+    size_t at = size / 2;
+    char* edited = malloc(size + 1);
+    memcpy(edited, buffer, at);
+    edited[at] = ' ';
+    memcpy(edited + at + 1, buffer + at, size - at);
+
+    Source_edit edit = { .start = at, .old_len = 0, .new_len = 1 };
+    Scanner scanner = { 0 };
+    double best = 0;
+
+    for (size_t r = 0; r < ROUNDS; r++) {
+        scanner = init_scanner(buffer, size);
+        scan_tokens(&scanner);
+
+        double begin = seconds();
+        rescan_tokens(&scanner, edited, size + 1, edit);
+        double elapsed = seconds() - begin;
+
+        if (r == 0 || elapsed < best) best = elapsed;
+        deallocate_tokens(scanner.tokens);
+    }
+
+    printf("rescanned %zu tokens after a 1 byte edit: %8.2f us\n",
+           scanner.tokens_count + 1,
+           best * 1e6);
+
+    free(edited);
+}
+
+int
+main(int argc, char** argv)
+{
+    Source_file file = { 0 };
+    if (argc > 1) file = readfile(argv[1]);
+    else file.data = generate(&file.size);
+
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t threads = cpus > 1 ? cpus : 1;
+
+    bench_lexer("switch", SWITCH_LEXER, 0, file.data, file.size);
+    bench_lexer("dfa", DFA_LEXER, 0, file.data, file.size);
+    printf("parallel scans with %zu threads\n", threads);
+    bench_lexer("switch", SWITCH_LEXER, threads, file.data, file.size);
+    bench_lexer("dfa", DFA_LEXER, threads, file.data, file.size);
+    bench_rescan(file.data, file.size);
+
+    freefile(file);
+}
\ No newline at end of file
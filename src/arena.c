@@ -0,0 +1,171 @@
+// clox-basic - C Language Implementation of jlox from Crafting Interpreters.
+//
+// Copyright (C) 2022 Amritpal Singh
+//
+// This file is part of clox-basic.
+//
+// clox-basic is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3
+// of the License, or (at your option) any later version.
+//
+// clox-basic is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied
+// warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// clox-basic. If not, see <https://www.gnu.org/licenses/>.
+
+#include <stdalign.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sysexits.h>
+
+#include "arena.h"
+#include "token.h"
+#include "utility.h"
+
+struct Arena_block {
+    Arena_block* next;
+    size_t size;
+    size_t used;
+    alignas(max_align_t) unsigned char data[];
+};
+
+/* round a size up so the next allocation stays aligned */
+static size_t
+align_size(size_t size)
+{
+    return (size + alignof(max_align_t) - 1) & ~(alignof(max_align_t) - 1);
+}
+
+/* initialise an empty arena, no memory is allocated until the first
+ * allocation
+ * Ret:
+ * @Arena : the arena
+ */
+Arena
+init_arena(void)
+{
+    return (Arena){ 0 };
+}
+
+/* allocate a new block and append it after the current one
+ * Params:
+ * @arena : the arena
+ * @size : the least number of bytes the block must hold
+ * Ret:
+ * @Arena_block* : the new block
+ */
+static Arena_block*
+new_block(Arena* arena, size_t size)
+{
+    if (size < ARENA_BLOCK_SIZE) size = ARENA_BLOCK_SIZE;
+
+    Arena_block* block = malloc(sizeof(Arena_block) + size);
+    if (block == NULL) {
+        error(NO_SOURCE_OFFSET, "Out of memory while allocating the arena");
+        exit(EX_OSERR);
+    }
+    *block = (Arena_block){ .size = size };
+
+    if (arena->current == NULL) {
+        arena->first = block;
+    } else {
+        block->next = arena->current->next;
+        arena->current->next = block;
+    }
+
+    arena->block_cnt++;
+    return block;
+}
+
+/* allocate memory from the arena
+ * Params:
+ * @arena : the arena
+ * @size : number of bytes to allocate
+ * Ret:
+ * @void* : memory aligned for any type, valid until the arena is reset
+ */
+void*
+arena_alloc(Arena* arena, size_t size)
+{
+    size = align_size(size);
+    Arena_block* block = arena->current;
+
+    /* blocks kept from before the last reset are reused first */
+    while (block == NULL || block->size - block->used < size) {
+        if (block != NULL && block->next != NULL) {
+            block = block->next;
+            block->used = 0;
+        } else {
+            block = new_block(arena, size);
+        }
+        arena->current = block;
+    }
+
+    void* memory = block->data + block->used;
+    block->used += size;
+    arena->used += size;
+    return memory;
+}
+
+/* grow an allocation of the arena, the contents are kept
+ * Params:
+ * @arena : the arena
+ * @memory : the allocation, NULL to allocate a new one
+ * @old_size : the size it was allocated with
+ * @new_size : the size it should have
+ * Ret:
+ * @void* : the grown allocation
+ */
+void*
+arena_grow(Arena* arena, void* memory, size_t old_size, size_t new_size)
+{
+    Arena_block* block = arena->current;
+    old_size = align_size(old_size);
+    new_size = align_size(new_size);
+
+    /* the last allocation of the block can simply be extended */
+    if (memory != NULL && block != NULL &&
+        (unsigned char*)memory + old_size == block->data + block->used &&
+        block->size - block->used >= new_size - old_size) {
+        block->used += new_size - old_size;
+        arena->used += new_size - old_size;
+        return memory;
+    }
+
+    void* grown = arena_alloc(arena, new_size);
+    if (memory != NULL) memcpy(grown, memory, old_size);
+    return grown;
+}
+
+/* release every allocation of the arena in one go, the blocks are kept
+ * Params:
+ * @arena : the arena
+ */
+void
+arena_reset(Arena* arena)
+{
+    arena->current = arena->first;
+    if (arena->first != NULL) arena->first->used = 0;
+    arena->used = 0;
+}
+
+/* free() the blocks of the arena
+ * Params:
+ * @arena : the arena
+ */
+void
+deallocate_arena(Arena* arena)
+{
+    Arena_block* block = arena->first;
+    while (block != NULL) {
+        Arena_block* next = block->next;
+        free(block);
+        block = next;
+    }
+    *arena = init_arena();
+}
\ No newline at end of file
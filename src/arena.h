@@ -0,0 +1,62 @@
+#pragma once
+// clox-basic - C Language Implementation of jlox from Crafting Interpreters.
+//
+// Copyright (C) 2022 Amritpal Singh
+//
+// This file is part of clox-basic.
+//
+// clox-basic is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3
+// of the License, or (at your option) any later version.
+//
+// clox-basic is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied
+// warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// clox-basic. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef CLOX_BASIC_ARENA_H
+#define CLOX_BASIC_ARENA_H
+
+#include <stddef.h>
+
+/* size of the blocks the arena carves allocations from, larger
+ * allocations get a block of their own */
+#define ARENA_BLOCK_SIZE (64L << 10)
+
+typedef struct Arena_block Arena_block;
+
+/* a bump allocator, memory is only given back all at once by
+ * arena_reset() and the blocks are kept around for the next use */
+typedef struct Arena {
+    Arena_block* first;
+    Arena_block* current;
+    /* bytes handed out since the last reset and blocks owned */
+    size_t used;
+    size_t block_cnt;
+} Arena;
+
+/* initialise an empty arena */
+Arena
+init_arena(void);
+
+/* allocate 'size' bytes aligned for any type */
+void*
+arena_alloc(Arena* arena, size_t size);
+
+/* grow an allocation, in place when it is the last one made */
+void*
+arena_grow(Arena* arena, void* memory, size_t old_size, size_t new_size);
+
+/* release every allocation at once */
+void
+arena_reset(Arena* arena);
+
+/* free() the blocks of the arena */
+void
+deallocate_arena(Arena* arena);
+
+#endif
\ No newline at end of file
@@ -20,7 +20,7 @@
 #include <stdio.h>
 
 #include "ast_printer.h"
-#include "parser.h"
+#include "expr_pool.h"
 #include "token.h"
 #include "utility.h"
 
@@ -30,95 +30,94 @@ ast_error(void)
     fprintf(stderr, RED_2 "lox_internal: argument to ast printer is null\n" RESET);
 }
 
-void
-literal_to_str(struct Literal_e* literal)
-{
-    if (literal == NULL) {
-        ast_error();
-        return;
-    }
+static void
+print_node(const Expr_pool* exprs, Expr_idx expr);
 
-    switch (literal->value.type) {
+static void
+literal_to_str(const Expr_node* literal)
+{
+    switch (literal->token) {
         case NUMBER:
-            fprintf(stdout, "%lf ", literal->value.num_literal);
+        case NUMBER_2:
+            fprintf(stdout, "%lf ", literal->number);
             break;
+        /* folded literals have no lexeme of their own */
         case STRING:
-            fprintf(stdout, "%s ", literal->value.lexeme);
+            fprintf(stdout, "%.*s ", (int)literal->len, literal->interned->chars);
             break;
         case TRUE:
-            fprintf(stdout, "%s ", literal->value.lexeme);
+            fprintf(stdout, "true ");
             break;
         case FALSE:
-            fprintf(stdout, "%s ", literal->value.lexeme);
+            fprintf(stdout, "false ");
             break;
         case NIL:
-            fprintf(stdout, "%s ", literal->value.lexeme);
+            fprintf(stdout, "nil ");
             break;
         default:
             break;
     }
 }
 
-void
-unary_to_str(struct Unary_e* unary)
+static void
+unary_to_str(const Expr_pool* exprs, const Expr_node* unary)
 {
-    if (unary == NULL) {
-        ast_error();
-        return;
-    }
-    fprintf(stdout, "(%s ", unary->Operator.lexeme);
-    unary->right->accept(unary->right);
+    fprintf(stdout, "(%.*s ", (int)unary->len, exprs->source + unary->offset);
+    print_node(exprs, unary->right);
     fprintf(stdout, ") ");
 }
 
-void
-binary_to_str(struct Binary_e* binary)
+static void
+binary_to_str(const Expr_pool* exprs, const Expr_node* binary)
 {
-
-    if (binary == NULL) {
-        ast_error();
-        return;
-    }
-    fprintf(stdout, "%s ", binary->Operator.lexeme);
+    fprintf(stdout, "%.*s ", (int)binary->len, exprs->source + binary->offset);
     if (binary->nests) fprintf(stdout, "(");
-    binary->left->accept(binary->left);
+    print_node(exprs, binary->left);
     if (binary->nests) fprintf(stdout, ") ");
-    binary->right->accept(binary->right);
+    print_node(exprs, binary->right);
 }
 
-void
-grouping_to_str(struct Grouping_e* grp)
+static void
+grouping_to_str(const Expr_pool* exprs, const Expr_node* grp)
 {
-    if (grp == NULL) {
-        ast_error();
-        return;
-    }
     fprintf(stdout, "(");
-    grp->expression->accept(grp->expression);
+    print_node(exprs, grp->left);
     fprintf(stdout, ") ");
 }
 
-void
-print_expr(Env_manager* env, Expr* ex)
+static void
+print_node(const Expr_pool* exprs, Expr_idx expr)
 {
-    if (ex == NULL) {
+    if (expr == NO_EXPR) {
         ast_error();
         return;
     }
-    switch (ex->type) {
+
+    const Expr_node* node = expr_node(exprs, expr);
+    switch (node->type) {
         case LITERAL:
-            ex->literal->accept(env, ex->literal);
+            literal_to_str(node);
             break;
         case UNARY:
-            ex->unary->accept(env, ex->unary);
+            unary_to_str(exprs, node);
             break;
         case BINARY:
-            ex->binary->accept(env, ex->binary);
+            binary_to_str(exprs, node);
             break;
         case GROUPING:
-            ex->group->accept(env, ex->group);
+            grouping_to_str(exprs, node);
             break;
         default:
             break;
     }
+}
+
+void
+print_expr(const Expr_pool* exprs, Expr_idx expr)
+{
+    if (exprs == NULL) {
+        ast_error();
+        return;
+    }
+    print_node(exprs, expr);
 }
\ No newline at end of file
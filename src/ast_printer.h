@@ -21,26 +21,11 @@
 #ifndef CLOX_BASIC_AST_PRINTER_H
 #define CLOX_BASIC_AST_PRINTER_H
 
-#include "parser.h"
+#include "expr_pool.h"
 #include "token.h"
 
-/* prints a literal expression to stdout */
+/* print an expression of the pool to stdout */
 void
-literal_to_str(struct Literal_e* literal);
+print_expr(const Expr_pool* exprs, Expr_idx expr);
 
-/* prints a unary expression to stdout */
-void
-unary_to_str(struct Unary_e* unary);
-
-/* prints a binary expression to stdout */
-void
-binary_to_str(struct Binary_e* binary);
-
-/* prints a group expression to stdout */
-void
-grouping_to_str(struct Grouping_e* grp);
-
-/* print an expression */
-void
-print_expr(Env_manager*, Expr*);
 #endif
\ No newline at end of file
@@ -0,0 +1,56 @@
+// clox-basic - C Language Implementation of jlox from Crafting Interpreters.
+//
+// Copyright (C) 2022 Amritpal Singh
+//
+// This file is part of clox-basic.
+//
+// clox-basic is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3
+// of the License, or (at your option) any later version.
+//
+// clox-basic is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied
+// warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// clox-basic. If not, see <https://www.gnu.org/licenses/>.
+#include <stbds.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "chunk.h"
+#include "value.h"
+
+Chunk
+init_chunk(void)
+{
+    return (Chunk){ 0 };
+}
+
+void
+write_chunk(Chunk* chunk, uint8_t byte, uint32_t offset)
+{
+    arrput(chunk->code, byte);
+    arrput(chunk->offsets, offset);
+}
+
+size_t
+add_constant(Chunk* chunk, Value value)
+{
+    arrput(chunk->constants, value);
+    return arrlenu(chunk->constants) - 1;
+}
+
+void
+deallocate_chunk(Chunk* chunk)
+{
+    for (size_t i = 0; i < arrlenu(chunk->constants); i++)
+        release_value(chunk->constants[i]);
+
+    arrfree(chunk->code);
+    arrfree(chunk->offsets);
+    arrfree(chunk->constants);
+    *chunk = init_chunk();
+}
@@ -0,0 +1,111 @@
+#pragma once
+// clox-basic - C Language Implementation of jlox from Crafting Interpreters.
+//
+// Copyright (C) 2022 Amritpal Singh
+//
+// This file is part of clox-basic.
+//
+// clox-basic is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3
+// of the License, or (at your option) any later version.
+//
+// clox-basic is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied
+// warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// clox-basic. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef CLOX_BASIC_CHUNK_H
+#define CLOX_BASIC_CHUNK_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "value.h"
+
+/* the instructions of the virtual machine. Operands follow the opcode as
+ * OPERAND_SIZE bytes, most significant first. Unless noted an instruction
+ * has no operands
+ *  OP_CONSTANT        : push the constant at the operand's index
+ *  OP_*_GLOBAL        : the global variable in the operand's slot
+ *  OP_*_LOCAL         : the local variable at the operand's index of the stack
+ *  OP_DEFINE_*        : pop the value of a declaration into the variable
+ *  OP_SET_*           : assign the value on top, it is left on the stack
+ *  OP_JUMP*           : jump the operand's bytes forward
+ *  OP_JUMP_IF_FALSE   : pop a condition and jump if it is falsy
+ *  OP_ENTER_BLOCK     : push the operand's undefined locals of a block
+ *  OP_EXIT_BLOCK      : pop the operand's locals of a block */
+enum OPCODE {
+    OP_CONSTANT,
+    OP_NIL,
+    OP_TRUE,
+    OP_FALSE,
+    OP_POP,
+    OP_GET_GLOBAL,
+    OP_DEFINE_GLOBAL,
+    OP_SET_GLOBAL,
+    OP_GET_LOCAL,
+    OP_DEFINE_LOCAL,
+    OP_SET_LOCAL,
+    OP_EQUAL,
+    OP_NOT_EQUAL,
+    OP_GREATER,
+    OP_GREATER_EQUAL,
+    OP_LESS,
+    OP_LESS_EQUAL,
+    OP_ADD,
+    OP_SUBTRACT,
+    OP_MULTIPLY,
+    OP_DIVIDE,
+    OP_MODULO,
+    OP_NOT,
+    OP_NEGATE,
+    OP_PRINT,
+    OP_JUMP,
+    OP_JUMP_IF_FALSE,
+    OP_ENTER_BLOCK,
+    OP_EXIT_BLOCK,
+    OP_RETURN,
+};
+
+enum { OPERAND_SIZE = 3, OPERAND_MAX = (1 << 8 * OPERAND_SIZE) - 1 };
+
+/* a compiled program. 'offsets' is the line table, the offset in the
+ * source of the expression or statement each byte of 'code' came from,
+ * error() resolves it to a line and column. The arrays are stb_ds arrays */
+typedef struct Chunk {
+    uint8_t* code;
+    uint32_t* offsets;
+    Value* constants;
+    /* the most values the stack holds while the chunk runs */
+    size_t max_stack;
+} Chunk;
+
+/* an empty chunk */
+Chunk
+init_chunk(void);
+
+/* append a byte to the code of the chunk */
+void
+write_chunk(Chunk* chunk, uint8_t byte, uint32_t offset);
+
+/* add a value to the constant pool and return its index, the pool
+ * keeps a reference to the value */
+size_t
+add_constant(Chunk* chunk, Value value);
+
+/* free the code and release the constants of the chunk */
+void
+deallocate_chunk(Chunk* chunk);
+
+/* the operand that starts at 'code' */
+static inline uint32_t
+read_operand(const uint8_t* code)
+{
+    return (uint32_t)code[0] << 16 | (uint32_t)code[1] << 8 | code[2];
+}
+
+#endif
@@ -26,66 +26,163 @@
 #include <string.h>
 #include <sysexits.h>
 
+#include "arena.h"
 #include "ast_printer.h"
+#include "constant_folder.h"
 #include "evaluator.h"
+#include "expr_pool.h"
 #include "environment.h"
+#include "parallel_scanner.h"
 #include "parser.h"
 #include "program.h"
+#include "resolver.h"
 #include "scanner.h"
 #include "token.h"
 #include "utility.h"
+#include "vm.h"
 
-/* run the interpreter
+/* drop the AST of the program, the whole tree goes at once. Until then
+ * the AST is not modified by running it and can be run again with
+ * execute_program()
  * Params:
- * @buffer : a null terminated buffer containing lox source code
- * @buf_len : size of the buffer to be interpreted
+ * @program : the program
  */
-void
-run(const char* buffer, size_t buf_len, Program* program)
+static void
+release_ast(Program* program)
 {
-    *program->scanner = init_scanner(buffer, buf_len);
-    scan_tokens(program->scanner);
+    program->statements = NULL;
+    arena_reset(&program->ast);
+    reset_expr_pool(&program->exprs, NULL);
+}
 
-    *program->parser = init_parser(program->scanner->tokens);
-    Statement* stmts = parse(program);
+/* run the parsed program on the backend it was asked for, the AST is
+ * kept so it can be run again
+ * Params:
+ * @program : the program, parsed without errors
+ */
+static void
+execute_program(Program* program)
+{
+    /* the tree-walking evaluator is the reference for the virtual machine */
+    if (program->bytecode)
+        interpret_bytecode(program);
+    else
+        interpret(program);
+}
 
-    program->statements = stmts;
+/* run the interpreter, the program takes ownership of the source. The AST
+ * of the previous source is released here and this one is kept until the
+ * next source is run
+ * Params:
+ * @source : the lox source code, released with freefile() at exit
+ */
+void
+run(Source_file source, Program* program)
+{
+    release_ast(program);
 
-    program->toks_list =
-      realloc(program->toks_list, sizeof(Token*) * (program->toks_list_cnt + 1));
-    program->tok_cnt =
-      realloc(program->tok_cnt, sizeof(size_t) * (program->toks_list_cnt + 1));
+    *program->scanner = init_scanner(source.data, source.size);
+    set_error_source(source.data, source.size);
+    program->scanner->strings = &program->strings;
 
-    program->toks_list[program->toks_list_cnt] = program->scanner->tokens;
-    program->tok_cnt[program->toks_list_cnt++] = program->scanner->tokens_count;
+    /* very large scripts are scanned ahead on several threads when there
+     * are any, the rest are streamed to the parser in bounded memory */
+    if (parallel_scan_pays(source.size)) scan_tokens_parallel(program->scanner, 0);
 
-    if (program->parser->had_error) goto expr_end;
+    /* the parser pulls the tokens from the scanner as it goes */
+    *program->parser =
+      init_parser(program->scanner, &program->ast, &program->exprs);
+    Statement* stmts = parse(program);
+    deallocate_tokens(program->scanner->tokens);
 
-    interpret(program);
+    program->statements = stmts;
 
-    for (size_t i = 0; i < program->parser->statements[0].count; i++) {
-        if (program->parser->statements[i].type == IF_STMT) continue;
-        if (program->parser->statements[i].type == BLOCK_STMT) continue;
-        deallocate_expr(program->parser->statements[i].exStmt.expression);
+#ifdef CLOX_CONSTANT_FOLDING
+    /* constant expressions are evaluated once, here */
+    if (stmts != NULL) {
+        size_t folded = fold_constants(&program->exprs, &program->strings);
+#ifdef CLOX_LOG_ALLOCATIONS
+        printf("Folded %zu constant expressions\n", folded);
+#endif
+        (void)folded;
     }
-expr_end:
-    free(program->statements);
-    free((void*)buffer);
+#endif
+
+    /* variables are looked up by the slot resolved here */
+    if (stmts != NULL && !resolve(program)) program->parser->had_error = true;
+
+    program->source_list =
+      realloc(program->source_list,
+              sizeof(Source_file) * (program->source_cnt + 1));
+    program->source_list[program->source_cnt++] = source;
+
+#ifdef CLOX_LOG_ALLOCATIONS
+    printf("Scanned %zu tokens from %zu bytes\n",
+           program->scanner->tokens_count + 1,
+           source.size);
+    printf("Allocated %zu bytes of AST from %zu arena blocks\n",
+           program->ast.used,
+           program->ast.block_cnt);
+    printf("Pushed %zu expressions, %zu bytes\n",
+           program->exprs.count,
+           program->exprs.count * sizeof(Expr_node));
+#endif
+
+    if (!program->parser->had_error) execute_program(program);
+}
+
+/* free everything the program holds
+ * Params:
+ * @program : the program, not used afterwards
+ */
+static void
+deallocate_program(Program* program)
+{
+    /* the variables may hold interned strings, so they go first */
+    deallocate_env_manager(program->env_mgr);
+    hmfree(program->globals);
+
+    set_error_source(NULL, 0);
+    for_range(i, program->source_cnt) freefile(program->source_list[i]);
+
+    free(program->source_list);
+    deallocate_intern_table(&program->strings);
+    deallocate_arena(&program->ast);
+    deallocate_expr_pool(&program->exprs);
+    free(program->scanner);
+    free(program->parser);
+}
+
+/* leave with 'status' after an error in a script, the variables hold
+ * references to strings that are released before the output is flushed
+ * Params:
+ * @program : the program
+ * @status : the exit status
+ */
+static void
+exit_program(Program* program, int status)
+{
+    deallocate_program(program);
+    fflush(stdout);
+    exit(status);
 }
 
 /* run the interpreter with a file
  * Params:
  * @filename : the name of file to be interpreted
+ * @runs : how many times the file is run, it is parsed only once
  */
 void
-runfile(const char* filename, Program* program)
+runfile(const char* filename, size_t runs, Program* program)
 {
-    size_t filesize = 0;
-    const char* filebuffer = readfile(filename, &filesize);
-    run(filebuffer, filesize, program);
+    run(readfile(filename), program);
+    for (size_t i = 1; i < runs; i++) {
+        if (program->parser->had_error || program->had_runtime_error) break;
+        execute_program(program);
+    }
 
-    if (program->parser->had_error) exit(EX_DATAERR);
-    if (program->had_runtime_error) exit(EX_SOFTWARE);
+    if (program->parser->had_error) exit_program(program, EX_DATAERR);
+    if (program->had_runtime_error) exit_program(program, EX_SOFTWARE);
 }
 
 /* run the interpreter as a RPEL*/
@@ -97,7 +194,7 @@ run_prompt(Program* program)
         if (line == NULL) return;
 
         add_history(line);
-        run(line, strlen(line), program);
+        run((Source_file){ .data = line, .size = strlen(line) }, program);
         program->parser->had_error = false;
     }
 }
@@ -105,33 +202,34 @@ run_prompt(Program* program)
 int
 main(int argc, char** argv)
 {
-    Environment** env = calloc(1, sizeof(Environment*));
-    Env_manager env_mgr = { .envs = env, .env_idx = 0 };
+    Env_manager env_mgr = init_env_manager();
     Scanner* scanner = calloc(1, sizeof(Scanner));
     Parser* parser = calloc(1, sizeof(Parser));
 
     Program program = { .env_mgr = &env_mgr, .parser = parser, .scanner = scanner };
 
-    sh_new_arena(program.env_mgr->envs[0]);
-    env_mgr.total_envs++;
+    int arg = 1;
+    if (arg < argc && strcmp(argv[arg], "--vm") == 0) {
+        program.bytecode = true;
+        arg++;
+    }
+
+    /* a script can be run several times from a single parse */
+    size_t runs = 1;
+    if (arg + 1 < argc && strcmp(argv[arg], "--runs") == 0) {
+        char* end = NULL;
+        runs = strtoul(argv[arg + 1], &end, 10);
+        if (*end != '\0') runs = 0;
+        arg += 2;
+    }
 
-    if (argc > 2) {
-        fprintf(stderr, "Usage: clox [script]\n");
+    if (argc - arg > 1 || runs == 0) {
+        fprintf(stderr, "Usage: clox [--vm] [--runs n] [script]\n");
         exit(EX_USAGE);
-    } else if (argc == 2) {
-        runfile(argv[1], &program);
+    } else if (argc - arg == 1) {
+        runfile(argv[arg], runs, &program);
     }
 
     run_prompt(&program);
-
-    shfree(env_mgr.envs[0]);
-
-    for_range(i, program.toks_list_cnt)
-      deallocate_tokens(program.toks_list[i], program.tok_cnt[i]);
-
-    free(program.toks_list);
-    free(program.tok_cnt);
-    free(program.env_mgr->envs);
-    free(program.scanner);
-    free(program.parser);
+    deallocate_program(&program);
 }
\ No newline at end of file
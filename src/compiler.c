@@ -0,0 +1,439 @@
+// clox-basic - C Language Implementation of jlox from Crafting Interpreters.
+//
+// Copyright (C) 2022 Amritpal Singh
+//
+// This file is part of clox-basic.
+//
+// clox-basic is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3
+// of the License, or (at your option) any later version.
+//
+// clox-basic is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied
+// warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// clox-basic. If not, see <https://www.gnu.org/licenses/>.
+#include <stbds.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "chunk.h"
+#include "compiler.h"
+#include "expr_pool.h"
+#include "parser.h"
+#include "program.h"
+#include "token.h"
+#include "utility.h"
+#include "value.h"
+
+/* the chunk being written and the blocks the statement being compiled
+ * is in. The locals of the open blocks are the bottom of the stack of
+ * the machine, the values of the expressions are pushed above them */
+typedef struct {
+    Chunk* chunk;
+    const Expr_pool* exprs;
+    /* stb_ds array of the stack index of the first local of every open
+     * block, innermost last */
+    uint32_t* block_bases;
+    /* the locals of the open blocks */
+    size_t local_cnt;
+    /* the values on the stack after the code written so far */
+    size_t stack_size;
+    bool had_error;
+} Compiler;
+
+/* how many values an instruction pushes, negative when it pops. Entering
+ * and leaving a block depends on the operand and is counted apart */
+static const int8_t stack_effects[] = {
+    [OP_CONSTANT] = 1,
+    [OP_NIL] = 1,
+    [OP_TRUE] = 1,
+    [OP_FALSE] = 1,
+    [OP_POP] = -1,
+    [OP_GET_GLOBAL] = 1,
+    [OP_DEFINE_GLOBAL] = -1,
+    [OP_SET_GLOBAL] = 0,
+    [OP_GET_LOCAL] = 1,
+    [OP_DEFINE_LOCAL] = -1,
+    [OP_SET_LOCAL] = 0,
+    [OP_EQUAL] = -1,
+    [OP_NOT_EQUAL] = -1,
+    [OP_GREATER] = -1,
+    [OP_GREATER_EQUAL] = -1,
+    [OP_LESS] = -1,
+    [OP_LESS_EQUAL] = -1,
+    [OP_ADD] = -1,
+    [OP_SUBTRACT] = -1,
+    [OP_MULTIPLY] = -1,
+    [OP_DIVIDE] = -1,
+    [OP_MODULO] = -1,
+    [OP_NOT] = 0,
+    [OP_NEGATE] = 0,
+    [OP_PRINT] = -1,
+    [OP_JUMP] = 0,
+    [OP_JUMP_IF_FALSE] = -1,
+    [OP_ENTER_BLOCK] = 0,
+    [OP_EXIT_BLOCK] = 0,
+    [OP_RETURN] = 0,
+};
+
+_Static_assert(sizeof(stack_effects) == OP_RETURN + 1,
+               "every opcode needs its stack effect");
+
+static void
+adjust_stack(Compiler* compiler, ptrdiff_t effect)
+{
+    compiler->stack_size += effect;
+    if (compiler->stack_size > compiler->chunk->max_stack)
+        compiler->chunk->max_stack = compiler->stack_size;
+}
+
+/* where in the source the last instruction came from, for the code of
+ * statements without a token of their own */
+static uint32_t
+current_offset(const Compiler* compiler)
+{
+    if (arrlenu(compiler->chunk->offsets) == 0) return 0;
+    return arrlast(compiler->chunk->offsets);
+}
+
+static void
+emit_op(Compiler* compiler, enum OPCODE op, uint32_t offset)
+{
+    write_chunk(compiler->chunk, op, offset);
+    adjust_stack(compiler, stack_effects[op]);
+}
+
+static void
+emit_operand(Compiler* compiler, size_t operand, uint32_t offset)
+{
+    if (operand > OPERAND_MAX) {
+        if (!compiler->had_error)
+            error(offset, "Compiler: Program is too large for the bytecode.");
+        compiler->had_error = true;
+    }
+
+    write_chunk(compiler->chunk, operand >> 16 & 0xff, offset);
+    write_chunk(compiler->chunk, operand >> 8 & 0xff, offset);
+    write_chunk(compiler->chunk, operand & 0xff, offset);
+}
+
+static void
+emit_op_operand(Compiler* compiler, enum OPCODE op, size_t operand, uint32_t offset)
+{
+    emit_op(compiler, op, offset);
+    emit_operand(compiler, operand, offset);
+}
+
+static void
+emit_constant(Compiler* compiler, Value value, uint32_t offset)
+{
+    emit_op_operand(
+      compiler, OP_CONSTANT, add_constant(compiler->chunk, value), offset);
+}
+
+/* write a forward jump whose distance is patched in later
+ * Ret:
+ * @size_t : where the operand of the jump is in the code
+ */
+static size_t
+emit_jump(Compiler* compiler, enum OPCODE op, uint32_t offset)
+{
+    emit_op_operand(compiler, op, 0, offset);
+    return arrlenu(compiler->chunk->code) - OPERAND_SIZE;
+}
+
+/* make the jump with the operand at 'at' land after the code written so far */
+static void
+patch_jump(Compiler* compiler, size_t at)
+{
+    size_t distance = arrlenu(compiler->chunk->code) - (at + OPERAND_SIZE);
+    if (distance > OPERAND_MAX) {
+        if (!compiler->had_error)
+            error(compiler->chunk->offsets[at],
+                  "Compiler: Too much code to jump over.");
+        compiler->had_error = true;
+    }
+
+    compiler->chunk->code[at] = distance >> 16 & 0xff;
+    compiler->chunk->code[at + 1] = distance >> 8 & 0xff;
+    compiler->chunk->code[at + 2] = distance & 0xff;
+}
+
+/* write an access to a variable declared 'depth' scopes out. Blocks
+ * are only entered where they are written, so which block that is and
+ * the place of its locals on the stack are known here
+ * Params:
+ * @compiler : the compiler
+ * @global_op : the instruction for a global variable
+ * @local_op : the instruction for a local variable
+ * @depth : the depth resolve() gave the variable
+ * @slot : the slot of the variable in its scope
+ * @offset : where in the source the access is
+ */
+static void
+emit_variable(Compiler* compiler,
+              enum OPCODE global_op,
+              enum OPCODE local_op,
+              uint32_t depth,
+              uint32_t slot,
+              uint32_t offset)
+{
+    size_t block_cnt = arrlenu(compiler->block_bases);
+
+    if (depth == block_cnt) {
+        emit_op_operand(compiler, global_op, slot, offset);
+        return;
+    }
+
+    size_t base = compiler->block_bases[block_cnt - 1 - depth];
+    emit_op_operand(compiler, local_op, base + slot, offset);
+}
+
+static void
+compile_expr(Compiler* compiler, Expr_idx expr, uint32_t offset);
+
+static void
+compile_literal(Compiler* compiler, const Expr_node* node)
+{
+    switch (node->token) {
+        /* NUMBER_2 is arithmetic folded by fold_constants() */
+        case NUMBER:
+        case NUMBER_2:
+            emit_constant(compiler, number_value(node->number), node->offset);
+            break;
+        /* interned strings live as long as the program */
+        case STRING:
+            emit_constant(compiler, obj_value(&node->interned->obj), node->offset);
+            break;
+        case TRUE:
+            emit_op(compiler, OP_TRUE, node->offset);
+            break;
+        case FALSE:
+            emit_op(compiler, OP_FALSE, node->offset);
+            break;
+        case NIL:
+            emit_op(compiler, OP_NIL, node->offset);
+            break;
+        case IDENTIFIER:
+            emit_variable(compiler,
+                          OP_GET_GLOBAL,
+                          OP_GET_LOCAL,
+                          node->depth,
+                          node->slot,
+                          node->offset);
+            break;
+        default:
+            emit_constant(compiler, invalid_value(), node->offset);
+            break;
+    }
+}
+
+static void
+compile_binary(Compiler* compiler, const Expr_node* node)
+{
+    compile_expr(compiler, node->left, node->offset);
+    compile_expr(compiler, node->right, node->offset);
+
+    switch (node->token) {
+        case PLUS:
+            emit_op(compiler, OP_ADD, node->offset);
+            break;
+        case MINUS:
+            emit_op(compiler, OP_SUBTRACT, node->offset);
+            break;
+        case STAR:
+            emit_op(compiler, OP_MULTIPLY, node->offset);
+            break;
+        case SLASH:
+            emit_op(compiler, OP_DIVIDE, node->offset);
+            break;
+        case MOD:
+            emit_op(compiler, OP_MODULO, node->offset);
+            break;
+        case GREATER:
+            emit_op(compiler, OP_GREATER, node->offset);
+            break;
+        case GREATER_EQUAL:
+            emit_op(compiler, OP_GREATER_EQUAL, node->offset);
+            break;
+        case LESS:
+            emit_op(compiler, OP_LESS, node->offset);
+            break;
+        case LESS_EQUAL:
+            emit_op(compiler, OP_LESS_EQUAL, node->offset);
+            break;
+        case EQUAL_EQUAL:
+            emit_op(compiler, OP_EQUAL, node->offset);
+            break;
+        case BANG_EQUAL:
+            emit_op(compiler, OP_NOT_EQUAL, node->offset);
+            break;
+        /* like the evaluator, any other operator gives the invalid value */
+        default:
+            emit_op(compiler, OP_POP, node->offset);
+            emit_op(compiler, OP_POP, node->offset);
+            emit_constant(compiler, invalid_value(), node->offset);
+            break;
+    }
+}
+
+/* write the code that leaves the value of an expression on the stack
+ * Params:
+ * @compiler : the compiler
+ * @expr : the expression, NO_EXPR gives the invalid value
+ * @offset : where in the source a missing expression would be
+ */
+static void
+compile_expr(Compiler* compiler, Expr_idx expr, uint32_t offset)
+{
+    if (expr == NO_EXPR) {
+        emit_constant(compiler, invalid_value(), offset);
+        return;
+    }
+
+    const Expr_node* node = expr_node(compiler->exprs, expr);
+    switch (node->type) {
+        case LITERAL:
+            compile_literal(compiler, node);
+            break;
+        case UNARY:
+            compile_expr(compiler, node->right, node->offset);
+            emit_op(compiler,
+                    node->token == MINUS ? OP_NEGATE : OP_NOT,
+                    node->offset);
+            break;
+        case GROUPING:
+            compile_expr(compiler, node->left, node->offset);
+            break;
+        case BINARY:
+            compile_binary(compiler, node);
+            break;
+        case VARIABLE:
+            compile_expr(compiler, node->right, node->offset);
+            emit_variable(compiler,
+                          OP_SET_GLOBAL,
+                          OP_SET_LOCAL,
+                          node->depth,
+                          node->slot,
+                          node->offset);
+            break;
+        /* the parser does not let a program with an invalid
+         * expression through, so this is a bug */
+        default:
+            error(node->offset, "Compiler: Internal error, invalid expression.");
+            compiler->had_error = true;
+            emit_constant(compiler, invalid_value(), node->offset);
+            break;
+    }
+}
+
+static void
+compile_stmt(Compiler* compiler, const Statement* stmt);
+
+/* the locals of a block are pushed when it is entered, a run of the
+ * block starts with them undefined */
+static void
+compile_block(Compiler* compiler, const Block* block, uint32_t offset)
+{
+    arrput(compiler->block_bases, compiler->local_cnt);
+    compiler->local_cnt += block->slot_cnt;
+
+    if (block->slot_cnt > 0) {
+        emit_op_operand(compiler, OP_ENTER_BLOCK, block->slot_cnt, offset);
+        adjust_stack(compiler, block->slot_cnt);
+    }
+
+    for (size_t i = 0; i < block->statements[0].count; i++)
+        compile_stmt(compiler, &block->statements[i]);
+
+    if (block->slot_cnt > 0) {
+        emit_op_operand(compiler, OP_EXIT_BLOCK, block->slot_cnt, offset);
+        adjust_stack(compiler, -(ptrdiff_t)block->slot_cnt);
+    }
+
+    compiler->local_cnt -= block->slot_cnt;
+    (void)arrpop(compiler->block_bases);
+}
+
+static void
+compile_if(Compiler* compiler, const If_stmt* if_stmt)
+{
+    uint32_t offset = if_stmt->condition == NO_EXPR
+                        ? current_offset(compiler)
+                        : expr_node(compiler->exprs, if_stmt->condition)->offset;
+
+    compile_expr(compiler, if_stmt->condition, offset);
+    size_t then_jump = emit_jump(compiler, OP_JUMP_IF_FALSE, offset);
+    compile_stmt(compiler, &if_stmt->branches[THEN_BRNCH]);
+
+    if (if_stmt->branches[ELSE_BRNCH].type == BAD_STMT) {
+        patch_jump(compiler, then_jump);
+        return;
+    }
+
+    size_t else_jump = emit_jump(compiler, OP_JUMP, offset);
+    patch_jump(compiler, then_jump);
+    compile_stmt(compiler, &if_stmt->branches[ELSE_BRNCH]);
+    patch_jump(compiler, else_jump);
+}
+
+static void
+compile_stmt(Compiler* compiler, const Statement* stmt)
+{
+    switch (stmt->type) {
+        case EXPR_STMT: {
+            uint32_t offset = stmt->exStmt.tok.offset;
+            compile_expr(compiler, stmt->exStmt.expression, offset);
+            emit_op(compiler, OP_POP, offset);
+            break;
+        }
+        case PRINT_STMT: {
+            uint32_t offset = stmt->prtStmt.tok.offset;
+            compile_expr(compiler, stmt->prtStmt.expression, offset);
+            emit_op(compiler, OP_PRINT, offset);
+            break;
+        }
+        case VAR_DECL_STMT: {
+            uint32_t offset = stmt->vardecl.tok.offset;
+            if (stmt->vardecl.expression == NO_EXPR)
+                emit_op(compiler, OP_NIL, offset);
+            else
+                compile_expr(compiler, stmt->vardecl.expression, offset);
+
+            /* the depth of a declaration is always 0 */
+            emit_variable(compiler,
+                          OP_DEFINE_GLOBAL,
+                          OP_DEFINE_LOCAL,
+                          0,
+                          stmt->vardecl.slot,
+                          offset);
+            break;
+        }
+        case IF_STMT:
+            compile_if(compiler, &stmt->ifStmt);
+            break;
+        case BLOCK_STMT:
+            compile_block(compiler, &stmt->block, current_offset(compiler));
+            break;
+        case BAD_STMT:
+            break;
+    }
+}
+
+bool
+compile(const Program* program, Chunk* chunk)
+{
+    Compiler compiler = { .chunk = chunk, .exprs = &program->exprs };
+
+    for (size_t i = 0; i < program->statements[0].count; i++)
+        compile_stmt(&compiler, &program->statements[i]);
+    emit_op(&compiler, OP_RETURN, current_offset(&compiler));
+
+    arrfree(compiler.block_bases);
+    return !compiler.had_error;
+}
@@ -0,0 +1,34 @@
+#pragma once
+// clox-basic - C Language Implementation of jlox from Crafting Interpreters.
+//
+// Copyright (C) 2022 Amritpal Singh
+//
+// This file is part of clox-basic.
+//
+// clox-basic is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3
+// of the License, or (at your option) any later version.
+//
+// clox-basic is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied
+// warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// clox-basic. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef CLOX_BASIC_COMPILER_H
+#define CLOX_BASIC_COMPILER_H
+
+#include <stdbool.h>
+
+#include "chunk.h"
+#include "program.h"
+
+/* compile the statements of a resolved program into 'chunk', returns
+ * false when the program is too large for the operands of the chunk */
+bool
+compile(const Program* program, Chunk* chunk);
+
+#endif
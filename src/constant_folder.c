@@ -0,0 +1,286 @@
+// clox-basic - C Language Implementation of jlox from Crafting Interpreters.
+//
+// Copyright (C) 2022 Amritpal Singh
+//
+// This file is part of clox-basic.
+//
+// clox-basic is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3
+// of the License, or (at your option) any later version.
+//
+// clox-basic is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied
+// warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// clox-basic. If not, see <https://www.gnu.org/licenses/>.
+
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sysexits.h>
+
+#include "constant_folder.h"
+#include "evaluator.h"
+#include "expr_pool.h"
+#include "intern.h"
+#include "parser.h"
+#include "token.h"
+#include "utility.h"
+#include "value.h"
+
+/* a literal whose value is known before running, only
+ * identifiers have to wait for their environment */
+static bool
+is_constant(const Expr_node* node)
+{
+    return node->type == LITERAL && node->token != IDENTIFIER;
+}
+
+/* the value a constant evaluates to */
+static Value
+constant_value(const Expr_node* node)
+{
+    switch (node->token) {
+        case NUMBER:
+        case NUMBER_2:
+            return number_value(node->number);
+        case STRING:
+            return obj_value(&node->interned->obj);
+        case TRUE:
+            return bool_value(true);
+        case FALSE:
+            return bool_value(false);
+        default:
+            return nil_value();
+    }
+}
+
+/* turn an operator or a grouping into a literal without children */
+static void
+make_literal(Expr_node* node, enum TOKEN_TYPE token)
+{
+    node->type = LITERAL;
+    node->token = token;
+    node->left = NO_EXPR;
+    node->right = NO_EXPR;
+    node->nests = false;
+}
+
+static void
+make_number(Expr_node* node, double number)
+{
+    make_literal(node, NUMBER_2);
+    node->number = number;
+}
+
+static void
+make_boolean(Expr_node* node, bool boolean)
+{
+    make_literal(node, boolean ? TRUE : FALSE);
+}
+
+/* the text of a string or number constant, numbers go to 'buffer' */
+static const char*
+constant_text(Value value, char buffer[NUMBER_TEXT_SIZE], size_t* len)
+{
+    if (is_string(value)) {
+        *len = as_string(value)->len;
+        return as_string(value)->chars;
+    }
+
+    *len = format_number(as_number(value), buffer);
+    return buffer;
+}
+
+/* concatenate two constants the way the evaluator does and intern the result
+ * Params:
+ * @strings : the intern table of the program
+ * @left : the left operand, a string or a number
+ * @right : the right operand, a string or a number
+ * Ret:
+ * @Interned_string* : the concatenation
+ */
+static const Interned_string*
+concatenate(Intern_table* strings, Value left, Value right)
+{
+    char left_text[NUMBER_TEXT_SIZE];
+    char right_text[NUMBER_TEXT_SIZE];
+    size_t left_len = 0;
+    size_t right_len = 0;
+    const char* left_chars = constant_text(left, left_text, &left_len);
+    const char* right_chars = constant_text(right, right_text, &right_len);
+
+    size_t len = left_len + right_len;
+    char* text = malloc(len + 1);
+    if (text == NULL) {
+        error(NO_SOURCE_OFFSET, "Out of memory while folding a string");
+        exit(EX_OSERR);
+    }
+    memcpy(text, left_chars, left_len);
+    memcpy(text + left_len, right_chars, right_len);
+
+    const Interned_string* interned = intern_string(strings, text, len);
+
+    free(text);
+    return interned;
+}
+
+/* fold a unary expression on a constant, operations
+ * that fail at runtime are left to report their error */
+static bool
+fold_unary(Expr_node* node, Value right)
+{
+    switch (node->token) {
+        case MINUS:
+            if (!is_number(right)) return false;
+
+            /* a negation is a plain NUMBER without a lexeme */
+            make_literal(node, NUMBER);
+            node->number = -as_number(right);
+            node->len = 0;
+            return true;
+
+        /* only nil and false are falsy */
+        case BANG:
+            make_boolean(node, is_nil(right) || (is_bool(right) && !as_bool(right)));
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+/* fold a binary expression on two constants, operations
+ * that fail at runtime are left to report their error */
+static bool
+fold_binary(Expr_node* node, Intern_table* strings, Value left, Value right)
+{
+    bool numbers = is_number(left) && is_number(right);
+
+    switch (node->token) {
+        case MINUS:
+            if (!numbers) return false;
+            make_number(node, as_number(left) - as_number(right));
+            return true;
+
+        case STAR:
+            if (!numbers) return false;
+            make_number(node, as_number(left) * as_number(right));
+            return true;
+
+        /* division by zero is a runtime error, so is anything the
+         * evaluator takes for zero */
+        case SLASH:
+            if (!numbers || as_number(right) == 0 || !isfinite(as_number(right)))
+                return false;
+            make_number(node, as_number(left) / as_number(right));
+            return true;
+
+        case MOD:
+            if (!numbers || as_number(right) == 0 || !isfinite(as_number(right)))
+                return false;
+            make_number(node, fmod(as_number(left), as_number(right)));
+            return true;
+
+        case PLUS: {
+            if (numbers) {
+                make_number(node, as_number(left) + as_number(right));
+                return true;
+            }
+            if (!(is_number(left) || is_string(left)) ||
+                !(is_number(right) || is_string(right)))
+                return false;
+
+            const Interned_string* interned = concatenate(strings, left, right);
+            make_literal(node, STRING);
+            node->interned = interned;
+            node->len = interned->len;
+            return true;
+        }
+
+        case GREATER:
+            if (!numbers) return false;
+            make_boolean(node, isgreater(as_number(left), as_number(right)));
+            return true;
+
+        case GREATER_EQUAL:
+            if (!numbers) return false;
+            make_boolean(node, isgreaterequal(as_number(left), as_number(right)));
+            return true;
+
+        case LESS:
+            if (!numbers) return false;
+            make_boolean(node, isless(as_number(left), as_number(right)));
+            return true;
+
+        case LESS_EQUAL:
+            if (!numbers) return false;
+            make_boolean(node, islessequal(as_number(left), as_number(right)));
+            return true;
+
+        case BANG_EQUAL:
+            make_boolean(node, !is_equal(left, right));
+            return true;
+
+        case EQUAL_EQUAL:
+            make_boolean(node, is_equal(left, right));
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+/* fold the constant expressions of the pool into literals.
+ * Children are pushed before their parents, so a single pass in
+ * pool order sees the operands of an expression already folded.
+ * Params:
+ * @exprs : the expression pool of the program
+ * @strings : the intern table for the folded strings
+ * Ret:
+ * @size_t : the number of expressions folded
+ */
+size_t
+fold_constants(Expr_pool* exprs, Intern_table* strings)
+{
+    size_t folded = 0;
+
+    for (size_t idx = 0; idx < exprs->count; idx++) {
+        Expr_node* node = &exprs->nodes[idx];
+        const Expr_node* left =
+          node->left != NO_EXPR ? expr_node(exprs, node->left) : NULL;
+        const Expr_node* right =
+          node->right != NO_EXPR ? expr_node(exprs, node->right) : NULL;
+
+        switch (node->type) {
+            case GROUPING:
+                if (!is_constant(left)) break;
+                *node = *left;
+                folded++;
+                break;
+
+            case UNARY:
+                if (!is_constant(right)) break;
+                folded += fold_unary(node, constant_value(right));
+                break;
+
+            case BINARY:
+                if (!is_constant(left) || !is_constant(right)) break;
+                folded += fold_binary(node,
+                                      strings,
+                                      constant_value(left),
+                                      constant_value(right));
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    return folded;
+}
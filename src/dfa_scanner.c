@@ -0,0 +1,291 @@
+// clox-basic - C Language Implementation of jlox from Crafting Interpreters.
+//
+// Copyright (C) 2022 Amritpal Singh
+//
+// This file is part of clox-basic.
+//
+// clox-basic is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3
+// of the License, or (at your option) any later version.
+//
+// clox-basic is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied
+// warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// clox-basic. If not, see <https://www.gnu.org/licenses/>.
+
+/* a lexer core driven by a character class table and a state transition table
+ * that are both built at compile time. It recognises the longest token from
+ * the current position, backtracking to the last accepting state when needed
+ * (the '.' after "7" in "7." is not part of the number). The bodies of
+ * comments and strings are skipped by the vectorised helpers of scan_simd.c
+ * once the DFA has recognised how they start. */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "dfa_scanner.h"
+#include "scan_simd.h"
+#include "scanner.h"
+#include "token.h"
+#include "utility.h"
+
+/* character classes, unlike <ctype.h> they do not depend on the locale */
+enum CHAR_CLASS {
+    C_OTHER,
+    C_SPACE,
+    C_DIGIT,
+    C_ALPHA,
+    C_DOT,
+    C_SLASH,
+    C_STAR,
+    C_QUOTE,
+    C_BANG,
+    C_EQUAL,
+    C_LESS,
+    C_GREATER,
+    C_LEFT_PAREN,
+    C_RIGHT_PAREN,
+    C_LEFT_BRACE,
+    C_RIGHT_BRACE,
+    C_COMMA,
+    C_MINUS,
+    C_PLUS,
+    C_SEMICOLON,
+    C_MOD,
+    CLASS_CNT
+};
+
+static const uint8_t char_class[256] = {
+    [' '] = C_SPACE, ['\t'] = C_SPACE, ['\r'] = C_SPACE, ['\n'] = C_SPACE,
+    ['0'] = C_DIGIT, ['1'] = C_DIGIT, ['2'] = C_DIGIT, ['3'] = C_DIGIT,
+    ['4'] = C_DIGIT, ['5'] = C_DIGIT, ['6'] = C_DIGIT, ['7'] = C_DIGIT,
+    ['8'] = C_DIGIT, ['9'] = C_DIGIT, ['a'] = C_ALPHA, ['b'] = C_ALPHA,
+    ['c'] = C_ALPHA, ['d'] = C_ALPHA, ['e'] = C_ALPHA, ['f'] = C_ALPHA,
+    ['g'] = C_ALPHA, ['h'] = C_ALPHA, ['i'] = C_ALPHA, ['j'] = C_ALPHA,
+    ['k'] = C_ALPHA, ['l'] = C_ALPHA, ['m'] = C_ALPHA, ['n'] = C_ALPHA,
+    ['o'] = C_ALPHA, ['p'] = C_ALPHA, ['q'] = C_ALPHA, ['r'] = C_ALPHA,
+    ['s'] = C_ALPHA, ['t'] = C_ALPHA, ['u'] = C_ALPHA, ['v'] = C_ALPHA,
+    ['w'] = C_ALPHA, ['x'] = C_ALPHA, ['y'] = C_ALPHA, ['z'] = C_ALPHA,
+    ['A'] = C_ALPHA, ['B'] = C_ALPHA, ['C'] = C_ALPHA, ['D'] = C_ALPHA,
+    ['E'] = C_ALPHA, ['F'] = C_ALPHA, ['G'] = C_ALPHA, ['H'] = C_ALPHA,
+    ['I'] = C_ALPHA, ['J'] = C_ALPHA, ['K'] = C_ALPHA, ['L'] = C_ALPHA,
+    ['M'] = C_ALPHA, ['N'] = C_ALPHA, ['O'] = C_ALPHA, ['P'] = C_ALPHA,
+    ['Q'] = C_ALPHA, ['R'] = C_ALPHA, ['S'] = C_ALPHA, ['T'] = C_ALPHA,
+    ['U'] = C_ALPHA, ['V'] = C_ALPHA, ['W'] = C_ALPHA, ['X'] = C_ALPHA,
+    ['Y'] = C_ALPHA, ['Z'] = C_ALPHA,
+    ['.'] = C_DOT, ['/'] = C_SLASH, ['*'] = C_STAR, ['"'] = C_QUOTE,
+    ['!'] = C_BANG, ['='] = C_EQUAL, ['<'] = C_LESS, ['>'] = C_GREATER,
+    ['('] = C_LEFT_PAREN, [')'] = C_RIGHT_PAREN, ['{'] = C_LEFT_BRACE,
+    ['}'] = C_RIGHT_BRACE, [','] = C_COMMA, ['-'] = C_MINUS, ['+'] = C_PLUS,
+    [';'] = C_SEMICOLON, ['%'] = C_MOD,
+};
+
+/* DFA states, S_STOP has no transitions and ends the token */
+enum DFA_STATE {
+    S_STOP,
+    S_START,
+    S_SPACE,
+    S_NUMBER,
+    S_NUMBER_DOT,
+    S_FRACTION,
+    S_IDENTIFIER,
+    S_SLASH,
+    S_LINE_COMMENT,
+    S_BLOCK_COMMENT,
+    S_STRING,
+    S_BANG,
+    S_BANG_EQUAL,
+    S_EQUAL,
+    S_EQUAL_EQUAL,
+    S_LESS,
+    S_LESS_EQUAL,
+    S_GREATER,
+    S_GREATER_EQUAL,
+    S_LEFT_PAREN,
+    S_RIGHT_PAREN,
+    S_LEFT_BRACE,
+    S_RIGHT_BRACE,
+    S_COMMA,
+    S_DOT,
+    S_MINUS,
+    S_PLUS,
+    S_SEMICOLON,
+    S_STAR,
+    S_MOD,
+    S_INVALID,
+    STATE_CNT
+};
+
+/* missing entries are S_STOP */
+static const uint8_t transitions[STATE_CNT][CLASS_CNT] = {
+    [S_START] = { [C_OTHER] = S_INVALID,
+                  [C_SPACE] = S_SPACE,
+                  [C_DIGIT] = S_NUMBER,
+                  [C_ALPHA] = S_IDENTIFIER,
+                  [C_DOT] = S_DOT,
+                  [C_SLASH] = S_SLASH,
+                  [C_STAR] = S_STAR,
+                  [C_QUOTE] = S_STRING,
+                  [C_BANG] = S_BANG,
+                  [C_EQUAL] = S_EQUAL,
+                  [C_LESS] = S_LESS,
+                  [C_GREATER] = S_GREATER,
+                  [C_LEFT_PAREN] = S_LEFT_PAREN,
+                  [C_RIGHT_PAREN] = S_RIGHT_PAREN,
+                  [C_LEFT_BRACE] = S_LEFT_BRACE,
+                  [C_RIGHT_BRACE] = S_RIGHT_BRACE,
+                  [C_COMMA] = S_COMMA,
+                  [C_MINUS] = S_MINUS,
+                  [C_PLUS] = S_PLUS,
+                  [C_SEMICOLON] = S_SEMICOLON,
+                  [C_MOD] = S_MOD },
+    [S_SPACE] = { [C_SPACE] = S_SPACE },
+    [S_NUMBER] = { [C_DIGIT] = S_NUMBER, [C_DOT] = S_NUMBER_DOT },
+    [S_NUMBER_DOT] = { [C_DIGIT] = S_FRACTION },
+    [S_FRACTION] = { [C_DIGIT] = S_FRACTION },
+    [S_IDENTIFIER] = { [C_ALPHA] = S_IDENTIFIER, [C_DIGIT] = S_IDENTIFIER },
+    [S_SLASH] = { [C_SLASH] = S_LINE_COMMENT, [C_STAR] = S_BLOCK_COMMENT },
+    [S_BANG] = { [C_EQUAL] = S_BANG_EQUAL },
+    [S_EQUAL] = { [C_EQUAL] = S_EQUAL_EQUAL },
+    [S_LESS] = { [C_EQUAL] = S_LESS_EQUAL },
+    [S_GREATER] = { [C_EQUAL] = S_GREATER_EQUAL },
+};
+
+/* what to do once the DFA stops in an accepting state */
+enum DFA_ACTION {
+    A_REJECT, /* not an accepting state */
+    A_TOKEN,
+    A_SKIP,
+    A_LINE_COMMENT,
+    A_BLOCK_COMMENT,
+    A_STRING,
+    A_INVALID
+};
+
+static const struct {
+    uint8_t action;
+    uint8_t type;
+} accepts[STATE_CNT] = {
+    [S_SPACE] = { A_SKIP, 0 },
+    [S_NUMBER] = { A_TOKEN, NUMBER },
+    [S_FRACTION] = { A_TOKEN, NUMBER },
+    [S_IDENTIFIER] = { A_TOKEN, IDENTIFIER },
+    [S_SLASH] = { A_TOKEN, SLASH },
+    [S_LINE_COMMENT] = { A_LINE_COMMENT, 0 },
+    [S_BLOCK_COMMENT] = { A_BLOCK_COMMENT, 0 },
+    [S_STRING] = { A_STRING, STRING },
+    [S_BANG] = { A_TOKEN, BANG },
+    [S_BANG_EQUAL] = { A_TOKEN, BANG_EQUAL },
+    [S_EQUAL] = { A_TOKEN, EQUAL },
+    [S_EQUAL_EQUAL] = { A_TOKEN, EQUAL_EQUAL },
+    [S_LESS] = { A_TOKEN, LESS },
+    [S_LESS_EQUAL] = { A_TOKEN, LESS_EQUAL },
+    [S_GREATER] = { A_TOKEN, GREATER },
+    [S_GREATER_EQUAL] = { A_TOKEN, GREATER_EQUAL },
+    [S_LEFT_PAREN] = { A_TOKEN, LEFT_PAREN },
+    [S_RIGHT_PAREN] = { A_TOKEN, RIGHT_PAREN },
+    [S_LEFT_BRACE] = { A_TOKEN, LEFT_BRACE },
+    [S_RIGHT_BRACE] = { A_TOKEN, RIGHT_BRACE },
+    [S_COMMA] = { A_TOKEN, COMMA },
+    [S_DOT] = { A_TOKEN, DOT },
+    [S_MINUS] = { A_TOKEN, MINUS },
+    [S_PLUS] = { A_TOKEN, PLUS },
+    [S_SEMICOLON] = { A_TOKEN, SEMICOLON },
+    [S_STAR] = { A_TOKEN, STAR },
+    [S_MOD] = { A_TOKEN, MOD },
+    [S_INVALID] = { A_INVALID, 0 },
+};
+
+/* run the DFA from scanner->start and move scanner->current past the
+ * longest accepted prefix
+ * Params:
+ * @scanner : the scanner structure
+ * Ret:
+ * @enum DFA_STATE : the accepting state the DFA stopped in
+ */
+static enum DFA_STATE
+run_dfa(Scanner* scanner)
+{
+    const char* source = scanner->source;
+    size_t end = scanner->source_length;
+    size_t pos = scanner->start;
+    enum DFA_STATE state = S_START;
+    enum DFA_STATE accepted = S_STOP;
+
+    while (pos < end) {
+        state = transitions[state][char_class[(unsigned char)source[pos]]];
+        if (state == S_STOP) break;
+        pos++;
+
+        if (accepts[state].action != A_REJECT) {
+            accepted = state;
+            scanner->current = pos;
+        }
+    }
+
+    return accepted;
+}
+
+/* scans the next token with the DFA
+ * Params :
+ * @scanner : the scanner structure
+ * Ret :
+ * @Token : the next token, ENDOF once the whole source has been scanned
+ */
+Token
+dfa_next_token(Scanner* scanner)
+{
+    const char* source = scanner->source;
+    size_t end = scanner->source_length;
+
+    scanner->have_token = false;
+
+    while (scanner->current < end) {
+        scanner->start = scanner->current;
+        enum DFA_STATE state = run_dfa(scanner);
+
+        switch (accepts[state].action) {
+            case A_TOKEN: {
+                enum TOKEN_TYPE type = accepts[state].type;
+                if (type == IDENTIFIER)
+                    type = get_keyword(source + scanner->start,
+                                       scanner->current - scanner->start);
+                add_token(scanner, type, scanner->start, scanner->current);
+            } break;
+            case A_LINE_COMMENT:
+                scanner->current = find_byte(source, scanner->current, end, '\n');
+                break;
+            case A_BLOCK_COMMENT: {
+                size_t close = find_comment_end(source, scanner->current, end);
+                scanner->current = close == end ? end : close + 2;
+            } break;
+            case A_STRING: {
+                size_t quote = find_byte(source, scanner->current, end, '"');
+                if (quote == end) {
+                    scanner->current = end;
+                    scanner_error(scanner, "Unterminated String");
+                    break;
+                }
+                scanner->current = quote + 1;
+                add_token(scanner, STRING, scanner->start + 1, quote);
+            } break;
+            case A_INVALID:
+                scanner_error(scanner, "Unexpected character.");
+                break;
+            default:
+                break;
+        }
+
+        if (scanner->have_token) {
+            scanner->tokens_count++;
+            return scanner->token;
+        }
+    }
+
+    add_token(scanner, ENDOF, 0, 0);
+    return scanner->token;
+}
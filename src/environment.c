@@ -18,80 +18,124 @@
 // clox-basic. If not, see <https://www.gnu.org/licenses/>.
 #include "parser.h"
 #include "token.h"
+#include "utility.h"
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sysexits.h>
 #define STB_DS_IMPLEMENTATION
-#define STBDS_SIPHASH_2_4
 
 #include "environment.h"
 
-void
-define(Env_manager* env_mgr, char* string, Object value, size_t idx)
-{
-
-    Environment box = { .value = value,
-                        .key = string,
-                        .enclosing = &env_mgr->envs[env_mgr->env_idx - 1] };
-    define_with_struct(env_mgr, box, idx);
-}
+enum { ENV_MIN = 8 };
 
-void
-define_with_struct(Env_manager* env_mgr, Environment box, size_t idx)
+/* make sure an environment has room for 'count' variables, the slots not
+ * yet defined hold the invalid value
+ * Params:
+ * @env : the environment
+ * @count : the number of variables
+ */
+static void
+reserve_slots(Environment* env, size_t count)
 {
-    shputs((env_mgr->envs[idx]), box);
-}
+    if (count > env->capacity) {
+        size_t capacity = env->capacity ? env->capacity : ENV_MIN;
+        while (capacity < count) capacity *= 2;
+
+        Value* values = realloc(env->values, sizeof(Value) * capacity);
+        if (values == NULL) {
+            error(NO_SOURCE_OFFSET,
+                  "While creating Environment, reallocated values "
+                  "pointer is NULL");
+            exit(EX_OSERR);
+        }
+        env->values = values;
+        env->capacity = capacity;
+    }
 
-bool
-key_exists(Env_manager* env_mgr, char* key, size_t idx)
-{
-    return shgeti((env_mgr->envs[idx]), key) >= 0;
+    for (size_t i = env->count; i < count; i++)
+        env->values[i] = invalid_value();
+    env->count = count;
 }
 
-Object
-get_value(Env_manager* env_mgr, Token name, size_t idx)
+Env_manager
+init_env_manager(void)
 {
+    Env_manager env_mgr = { .envs = calloc(ENV_MIN, sizeof(Environment)),
+                            .env_idx = GLOBAL_ENV,
+                            .total_envs = ENV_MIN };
+    if (env_mgr.envs == NULL) {
+        error(NO_SOURCE_OFFSET, "Environments could not be allocated");
+        exit(EX_OSERR);
+    }
 
-    if (key_exists(env_mgr, name.lexeme, idx))
-        return shgets((env_mgr->envs[idx]), name.lexeme).value;
-
-    if (idx >= 1) return get_value(env_mgr, name, idx - 1);
-
-    return (Object){ .type = INVALID_TOKEN_INT };
+    return env_mgr;
 }
 
-Object
-assign(Env_manager* env_mgr, Token name, Object value, size_t idx)
+void
+deallocate_env_manager(Env_manager* env_mgr)
 {
+    while (env_mgr->env_idx > GLOBAL_ENV) pop_env(env_mgr);
 
-    if (key_exists(env_mgr, name.lexeme, idx)) {
-        define(env_mgr, name.lexeme, value, idx);
-        return (Object){ .type = VAR };
-    }
-
-    if (idx >= 1) {
-        assign(env_mgr, name, value, idx - 1);
-        return (Object){ .type = VAR };
-    }
+    Environment* globals = &env_mgr->envs[GLOBAL_ENV];
+    for (size_t i = 0; i < globals->count; i++) release_value(globals->values[i]);
 
-    return (Object){ .type = INVALID_TOKEN_INT };
+    for (size_t i = 0; i < env_mgr->total_envs; i++) free(env_mgr->envs[i].values);
+    free(env_mgr->envs);
+    *env_mgr = (Env_manager){ 0 };
 }
 
-Environment*
-create_env(void)
+/* the globals of earlier runs keep their slots, so the global
+ * scope only grows
+ * Params:
+ * @env_mgr : the environments
+ * @global_cnt : the number of globals declared so far
+ */
+void
+reserve_globals(Env_manager* env_mgr, size_t global_cnt)
 {
-    return malloc(sizeof(Environment));
+    Environment* globals = &env_mgr->envs[GLOBAL_ENV];
+    if (global_cnt > globals->count) reserve_slots(globals, global_cnt);
 }
 
-Environment
-init_env(void)
+/* enter a new scope, the slots of the environment stack grow geometrically
+ * and the values of a popped scope are reused by the next one
+ * Params:
+ * @env_mgr : the environments
+ * @slot_cnt : the number of variables declared in the scope
+ */
+void
+push_env(Env_manager* env_mgr, size_t slot_cnt)
 {
-    return (Environment){ 0 };
+    if (env_mgr->env_idx + 1 == env_mgr->total_envs) {
+        size_t total = env_mgr->total_envs * 2;
+        Environment* envs = realloc(env_mgr->envs, sizeof(Environment) * total);
+        if (envs == NULL) {
+            error(NO_SOURCE_OFFSET,
+                  "While creating Block Environment, reallocated environment "
+                  "pointer is NULL");
+            exit(EX_OSERR);
+        }
+        memset(envs + env_mgr->total_envs,
+               0,
+               sizeof(Environment) * (total - env_mgr->total_envs));
+        env_mgr->envs = envs;
+        env_mgr->total_envs = total;
+    }
+
+    Environment* env = &env_mgr->envs[++env_mgr->env_idx];
+    env->count = 0;
+    reserve_slots(env, slot_cnt);
 }
 
-Environment
-init_env_with(Env_manager* envmgr, size_t par_idx)
+/* leave the innermost scope, dropping the references of its variables
+ * Params:
+ * @env_mgr : the environments
+ */
+void
+pop_env(Env_manager* env_mgr)
 {
-
-    return (Environment){ .enclosing = &envmgr->envs[par_idx] };
-}
\ No newline at end of file
+    Environment* env = &env_mgr->envs[env_mgr->env_idx--];
+    for (size_t i = 0; i < env->count; i++) release_value(env->values[i]);
+}
@@ -22,35 +22,67 @@
 
 #include <stbds.h>
 #include <stddef.h>
+#include <stdint.h>
 
+#include "intern.h"
 #include "program.h"
 #include "parser.h"
+#include "value.h"
 
+/* the variables of a scope, indexed by the slot resolve() gave
+ * their declaration. The values are kept for the next scope that
+ * is pushed in the place of this one */
 typedef struct Env_t {
-    char* key;
-    Object value;
-    Environment** enclosing;
+    Value* values;
+    size_t count;
+    size_t capacity;
 } Environment;
 
-Environment*
-create_env(void);
+/* an environment stack with only the global scope, which is empty */
+Env_manager
+init_env_manager(void);
 
-Environment
-init_env(void);
+/* free every environment of the stack */
+void
+deallocate_env_manager(Env_manager* env_mgr);
 
-Environment
-init_env_with(Env_manager* envmgr, size_t par_idx);
+/* make room for the globals declared so far, new ones are undefined */
+void
+reserve_globals(Env_manager* env_mgr, size_t global_cnt);
 
+/* enter a new scope with room for 'slot_cnt' variables */
 void
-define(Env_manager* env_mgr, char* string, Object value, size_t idx);
+push_env(Env_manager* env_mgr, size_t slot_cnt);
 
+/* leave the innermost scope, its variables are released */
 void
-define_with_struct(Env_manager* env_mgr, Environment, size_t idx);
+pop_env(Env_manager* env_mgr);
+
+/* set a variable of the innermost scope, the environment takes over
+ * the reference of the value and drops the one of the old value */
+static inline void
+define(Env_manager* env_mgr, uint32_t slot, Value value)
+{
+    Value* variable = &env_mgr->envs[env_mgr->env_idx].values[slot];
+    release_value(*variable);
+    *variable = value;
+}
 
-Object
-get_value(Env_manager* env_mgr, Token name, size_t idx);
+/* the value of a variable declared 'depth' scopes out, borrowed
+ * from the environment */
+static inline Value
+get_value(const Env_manager* env_mgr, uint32_t depth, uint32_t slot)
+{
+    return env_mgr->envs[env_mgr->env_idx - depth].values[slot];
+}
 
-Object
-assign(Env_manager* env_mgr, Token name, Object value, size_t idx);
+/* set a variable declared 'depth' scopes out, like define() */
+static inline void
+assign(Env_manager* env_mgr, uint32_t depth, uint32_t slot, Value value)
+{
+    Value* variable = &env_mgr->envs[env_mgr->env_idx - depth].values[slot];
+    release_value(*variable);
+    *variable = value;
+}
 
 #endif
\ No newline at end of file
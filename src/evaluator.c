@@ -16,83 +16,68 @@
 //
 // You should have received a copy of the GNU General Public License along with
 // clox-basic. If not, see <https://www.gnu.org/licenses/>.
-
-#include <assert.h>
 #include <math.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <stdarg.h>
 
 #include "evaluator.h"
+#include "expr_pool.h"
 #include "parser.h"
 #include "program.h"
+#include "resolver.h"
 #include "token.h"
 #include "utility.h"
+#include "value.h"
 #include "environment.h"
 
-enum LIMITS { DOUBLE_MAX_DIG = 19 };
-
 /**** utility functions for the evaluator ****/
 
-Object
-evaluate_identifier(Env_manager* env_mgr, Expr* expr);
+Value
+evaluate_identifier(Env_manager* env_mgr, const Expr_pool* exprs, Expr_idx expr);
 
-static Object
-get_object_from_literal(Env_manager* env_mgr, Expr* expr)
+static Value
+get_value_from_literal(Env_manager* env_mgr, const Expr_pool* exprs, Expr_idx expr)
 {
-    if (expr->type != LITERAL) return (Object){ .type = INVALID_TOKEN_INT };
+    const Expr_node* node = expr_node(exprs, expr);
+
+    if (node->type != LITERAL) return invalid_value();
 
-    switch (expr->literal->value.type) {
+    switch (node->token) {
+        /* NUMBER_2 is arithmetic folded by fold_constants() */
         case NUMBER:
-            return (Object){ .number = expr->literal->value.num_literal,
-                             .string = expr->literal->value.lexeme,
-                             .string_len = expr->literal->value.lexeme_len,
-                             .type = NUMBER };
+        case NUMBER_2:
+            return number_value(node->number);
+        /* string literals are interned, see is_equal() */
         case STRING:
-            return (Object){ .string = expr->literal->value.lexeme,
-                             .string_len = expr->literal->value.lexeme_len,
-                             .type = STRING };
+            return obj_value(&node->interned->obj);
         case TRUE:
-            return (Object){ .string = expr->literal->value.lexeme,
-                             .string_len = expr->literal->value.lexeme_len,
-                             .type = TRUE };
+            return bool_value(true);
         case FALSE:
-            return (Object){ .string = expr->literal->value.lexeme,
-                             .string_len = expr->literal->value.lexeme_len,
-                             .type = FALSE };
+            return bool_value(false);
         case NIL:
-            return (Object){ .string = expr->literal->value.lexeme, .type = NIL };
+            return nil_value();
 
         case IDENTIFIER:
-            return evaluate_identifier(env_mgr, expr);
+            return evaluate_identifier(env_mgr, exprs, expr);
 
         default:
-            return (Object){ .type = INVALID_TOKEN_INT };
+            return invalid_value();
     }
 }
 
-static bool
-is_truthy(Object object)
+bool
+is_truthy(Value value)
 {
-    if (object.type == INVALID_TOKEN_INT) return false;
-    if (object.type == NIL) return false;
-    if (object.type == FALSE) return false;
+    if (is_invalid(value)) return false;
+    if (is_nil(value)) return false;
+    if (is_bool(value)) return as_bool(value);
 
     return true;
 }
 
-static enum TOKEN_TYPE
-boolean_type(bool b)
-{
-    if (b == true) return TRUE;
-    if (b == false) return FALSE;
-
-    __builtin_unreachable();
-}
-
 static bool
 is_floating_almost_equal(double a, double b)
 {
@@ -107,477 +92,507 @@ is_floating_almost_equal(double a, double b)
     return false;
 }
 
+/* strings made at runtime are compared by their characters, the
+ * cached length and hash tell most unequal strings apart at once */
 static bool
-True(Object a)
+is_string_equal(const Obj_string* a, const Obj_string* b)
 {
-    return a.type == TRUE;
+    if (a == b) return true;
+
+    /* string literals are interned, equal ones are the same object */
+    if (a->obj.type == OBJ_INTERNED && b->obj.type == OBJ_INTERNED) return false;
+
+    return a->len == b->len && a->hash == b->hash &&
+           memcmp(a->chars, b->chars, a->len) == 0;
 }
 
-static bool
-False(Object a)
+bool
+is_equal(Value a, Value b)
 {
-    return !True(a);
+    if (is_invalid(a) || is_invalid(b)) return is_invalid(a) && is_invalid(b);
+    if (is_nil(a) || is_nil(b)) return is_nil(a) && is_nil(b);
+
+    if (is_bool(a) && is_bool(b)) return as_bool(a) == as_bool(b);
+
+    if (is_number(a) && is_number(b))
+        return is_floating_almost_equal(as_number(a), as_number(b));
+
+    /* ropes are only flattened when their lengths match */
+    if (is_string(a) && is_string(b))
+        return string_length(a) == string_length(b) &&
+               is_string_equal(as_string(a), as_string(b));
+
+    /* values of different types are never equal */
+    return false;
 }
 
-static bool
-is_equal(Object a, Object b)
+static void
+runtime_error(uint32_t offset, const char* message, bool* had_runtime_error)
 {
-    if (a.type == INVALID_TOKEN_INT && b.type == INVALID_TOKEN_INT) return true;
-    if (a.type == INVALID_TOKEN_INT || b.type == INVALID_TOKEN_INT) return false;
-    if (a.type == NIL && b.type == NIL) return true;
-    if (a.type == NIL || b.type == NIL) return false;
-
-    /* boolean truth table */
-    if (True(a) && True(b)) return true;
-    if (True(a) && False(b)) return false;
-    if (False(a) && True(b)) return false;
-    if (False(a) && False(b)) return true;
-
-    /* comparison between a string and a number is always false */
-    if ((a.type == STRING && b.type == NUMBER) ||
-        (a.type == NUMBER && b.type == STRING)) {
-        return false;
-    }
+    error(offset, message);
+    *had_runtime_error = true;
+}
 
-    /* comparison between a number and a boolean is always false */
-    if (((a.type == TRUE || a.type == FALSE) && b.type == NUMBER) ||
-        (a.type == NUMBER && (b.type == TRUE || b.type == FALSE))) {
-        return false;
+/* the text of a value, numbers are formatted into 'buffer', the length is
+ * returned through 'len'
+ * Params:
+ * @value : a valid value
+ * @buffer : where the text of a number goes
+ * @len : the length of the text
+ * Ret:
+ * @const char* : the text, not necessarily null-terminated
+ */
+static const char*
+stringify(Value value, char buffer[NUMBER_TEXT_SIZE], size_t* len)
+{
+    if (is_number(value)) {
+        *len = format_number(as_number(value), buffer);
+        return buffer;
     }
-
-    /* compare two strings */
-    if (a.type == STRING && b.type == STRING) {
-        int z = strcmp(a.string, b.string);
-        if (z == 0) return true;
-        return false;
+    if (is_string(value)) {
+        *len = as_string(value)->len;
+        return as_string(value)->chars;
+    }
+    if (is_nil(value)) {
+        *len = strlen("nil");
+        return "nil";
+    }
+    if (as_bool(value)) {
+        *len = strlen("true");
+        return "true";
     }
 
-    /* compare two numbers */
-    return is_floating_almost_equal(a.number, b.number);
+    *len = strlen("false");
+    return "false";
 }
 
-static bool
-check_number_operands(enum TOKEN_TYPE chktype, size_t objcnt, ...)
+void
+print_value(Value value)
 {
-    Object obj;
-    va_list obj_list;
-    va_start(obj_list, objcnt);
+    /* an erroneous expression was already reported */
+    if (is_invalid(value)) return;
 
-    for (size_t i = 0; i < objcnt; i++) {
-        obj = va_arg(obj_list, Object);
-        if (obj.type != chktype && obj.type != NUMBER_2) return false;
-    }
-    return true;
+    char text[NUMBER_TEXT_SIZE];
+    size_t len = 0;
+    const char* str = stringify(value, text, &len);
+    printf("%.*s\n", (int)len, str);
 }
 
-static void
-runtime_error(Token Operator, const char* message, bool* had_runtime_error)
+/* an operand of a concatenation as an object with its own reference,
+ * a number becomes a string of its text */
+static Obj*
+concatenation_part(Value value, const char* text, size_t len)
 {
-    error(Operator.line, Operator.col, message);
-    *had_runtime_error = true;
+    if (is_number(value)) return &concatenate_chars(text, len, "", 0)->obj;
+
+    return as_obj(retain_value(value));
+}
+
+/* concatenate the text of two strings or numbers. Short results are
+ * copied into a new string, long ones share the operands in a rope so
+ * building a string piece by piece does not copy it over and over
+ * Params:
+ * @left : the left operand
+ * @right : the right operand
+ * Ret:
+ * @Value : the string made at runtime, the operands are left to the caller
+ */
+static Value
+concatenate(Value left, Value right)
+{
+    char left_text[NUMBER_TEXT_SIZE];
+    char right_text[NUMBER_TEXT_SIZE];
+    size_t left_len = is_number(left) ? format_number(as_number(left), left_text)
+                                      : string_length(left);
+    size_t right_len = is_number(right)
+                         ? format_number(as_number(right), right_text)
+                         : string_length(right);
+
+    if (left_len + right_len >= ROPE_MIN_LEN) {
+        Obj_rope* rope = make_rope(concatenation_part(left, left_text, left_len),
+                                   concatenation_part(right, right_text, right_len));
+        return obj_value(&rope->obj);
+    }
+
+    /* the operands are short, so neither is a rope */
+    const char* left_chars = is_number(left) ? left_text : as_string(left)->chars;
+    const char* right_chars =
+      is_number(right) ? right_text : as_string(right)->chars;
+
+    Obj_string* string =
+      concatenate_chars(left_chars, left_len, right_chars, right_len);
+    return obj_value(&string->obj);
 }
 
 /****** Actual Evaluator code ******/
-static Object
-evaluate_literal(Env_manager* env_mgr, Expr* expr)
+static Value
+evaluate_literal(Env_manager* env_mgr, const Expr_pool* exprs, Expr_idx expr)
 {
-    return get_object_from_literal(env_mgr, expr);
+    return get_value_from_literal(env_mgr, exprs, expr);
 }
 
-static Object
-evaluate_unary(Env_manager* env_mgr, Expr* expr, bool* had_runtime_error)
+static Value
+evaluate_unary(Env_manager* env_mgr,
+               const Expr_pool* exprs,
+               Expr_idx expr,
+               bool* had_runtime_error)
 {
-    Object right = evaluate(env_mgr, expr->unary->right, had_runtime_error);
+    const Expr_node* unary = expr_node(exprs, expr);
+    Value right = evaluate(env_mgr, exprs, unary->right, had_runtime_error);
 
-    switch (expr->unary->Operator.type) {
+    Value result =
+      unary_operation(unary->token, unary->offset, right, had_runtime_error);
+    release_value(right);
+    return result;
+}
+
+static Value
+evaluate_group(Env_manager* env_mgr,
+               const Expr_pool* exprs,
+               Expr_idx expr,
+               bool* had_runtime_error)
+{
+    return evaluate(env_mgr, exprs, expr_node(exprs, expr)->left, had_runtime_error);
+}
+
+/* apply a unary operator, the operand is borrowed */
+Value
+unary_operation(uint8_t op, uint32_t offset, Value right, bool* had_runtime_error)
+{
+    switch (op) {
         case MINUS:
-            if (!check_number_operands(NUMBER, 1, right)) {
-                runtime_error(expr->unary->Operator,
-                              "Runtime: Operand must be a number",
-                              had_runtime_error);
-                return (Object){ .type = INVALID_TOKEN_INT };
+            if (!is_number(right)) {
+                runtime_error(
+                  offset, "Runtime: Operand must be a number", had_runtime_error);
+                return invalid_value();
             }
-            return (Object){ .number = -right.number, .type = NUMBER };
+            return number_value(-as_number(right));
 
-        case BANG: {
-            /* only invalid object and false and NIL are Falsy, rest are Truthy
-             */
-            bool what = !is_truthy(right);
-            return (Object){ .boolean = what, .type = boolean_type(what) };
-        }
+        /* only invalid values and false and NIL are Falsy, rest are Truthy */
+        case BANG:
+            return bool_value(!is_truthy(right));
         default:
             __builtin_unreachable();
     }
 }
 
-static Object
-evaluate_group(Env_manager* env_mgr, Expr* expr, bool* had_runtime_error)
-{
-    return evaluate(env_mgr, expr->group->expression, had_runtime_error);
-}
-
-static Object
-evaluate_binary(Env_manager* env_mgr, Expr* expr, bool* had_runtime_error)
+/* apply a binary operator, the operands are borrowed */
+Value
+binary_operation(uint8_t op,
+                 uint32_t offset,
+                 Value left,
+                 Value right,
+                 bool* had_runtime_error)
 {
-    Object left = evaluate(env_mgr, expr->binary->left, had_runtime_error);
-    Object right = evaluate(env_mgr, expr->binary->right, had_runtime_error);
-
-    switch (expr->binary->Operator.type) {
+    switch (op) {
         case MINUS:
-            if (!check_number_operands(NUMBER, 2, left, right)) {
-                runtime_error(expr->binary->Operator,
+            if (!is_number(left) || !is_number(right)) {
+                runtime_error(offset,
                               "Runtime: Operands must be numbers",
                               had_runtime_error);
-                return (Object){ .type = INVALID_TOKEN_INT };
+                return invalid_value();
             }
-            char* str = calloc(DOUBLE_MAX_DIG + 1, sizeof(char));
-            snprintf(str, DOUBLE_MAX_DIG, "%lf", left.number - right.number);
-            return (Object){ .number = left.number - right.number,
-                             .string = str,
-                             .string_len = strlen(str),
-                             .type = NUMBER_2 };
+            return number_value(as_number(left) - as_number(right));
 
         case PLUS:
-            if ((left.type == NUMBER || left.type == NUMBER_2) &&
-                (right.type == NUMBER || right.type == NUMBER_2)) {
-                char* str = calloc(DOUBLE_MAX_DIG + 1, sizeof(char));
-                snprintf(str, DOUBLE_MAX_DIG, "%lf", left.number + right.number);
-                return (Object){ .number = left.number + right.number,
-                                 .string = str,
-                                 .string_len = strlen(str),
-                                 .type = NUMBER_2 };
+            if (is_number(left) && is_number(right)) {
+                return number_value(as_number(left) + as_number(right));
             }
 
-            if (((left.type == NUMBER || left.type == NUMBER_2) &&
-                 ((right.type == STRING) || (right.type == STRING_2))) ||
-                (((left.type == STRING) || (left.type == STRING_2)) &&
-                 (right.type == NUMBER || right.type == NUMBER_2)) ||
-                (((left.type == STRING) || (left.type == STRING_2)) &&
-                 ((right.type == STRING) || (right.type == STRING_2)))) {
-                char* bigstr =
-                  calloc(left.string_len + right.string_len + 1, sizeof(char));
-                if (bigstr == NULL) {
-                    error(expr->binary->left->literal->value.line,
-                          expr->binary->left->literal->value.col,
-                          "Memory not allocated");
-                }
-                memccpy(bigstr, left.string, '\0', left.string_len);
-                strncat(bigstr, right.string, right.string_len);
-
-                if (left.type == STRING_2 || left.type == NUMBER ||
-                    left.type == NUMBER_2)
-                    free(left.string);
-                if (right.type == STRING_2 || right.type == NUMBER ||
-                    right.type == NUMBER_2)
-                    free(right.string);
-                return (Object){ .string = bigstr,
-                                 .string_len =
-                                   left.string_len + right.string_len + 1,
-                                 .type = STRING_2 };
+            if ((is_number(left) || is_string(left)) &&
+                (is_number(right) || is_string(right))) {
+                return concatenate(left, right);
             }
 
-            runtime_error(expr->binary->Operator,
+            runtime_error(offset,
                           "Runtime: Operands must either be a number or a string.",
                           had_runtime_error);
-            return (Object){ .type = INVALID_TOKEN_INT };
+            return invalid_value();
 
         case SLASH: {
-            if (!check_number_operands(NUMBER, 2, left, right)) {
-                if (left.type == NUMBER_2) free(left.string);
-                if (right.type == NUMBER_2) free(right.string);
-                runtime_error(expr->binary->Operator,
+            if (!is_number(left) || !is_number(right)) {
+                runtime_error(offset,
                               "Runtime: Operands must be numbers",
                               had_runtime_error);
+                return invalid_value();
             }
-            if (is_floating_almost_equal(right.number, 0.0f)) {
-                if (left.type == NUMBER_2) free(left.string);
-                if (right.type == NUMBER_2) free(right.string);
-                runtime_error(expr->binary->Operator,
+            if (is_floating_almost_equal(as_number(right), 0.0f)) {
+                runtime_error(offset,
                               "Runtime: Division by zero is not allowed.",
                               had_runtime_error);
-                return (Object){ .type = INVALID_TOKEN_INT };
+                return invalid_value();
             }
-            if (left.type == NUMBER_2) free(left.string);
-            if (right.type == NUMBER_2) free(right.string);
-            char* str = calloc(DOUBLE_MAX_DIG + 1, sizeof(char));
-            snprintf(str, DOUBLE_MAX_DIG, "%lf", left.number / right.number);
-            return (Object){ .number = left.number / right.number,
-                             .string = str,
-                             .string_len = strlen(str),
-                             .type = NUMBER_2 };
+            return number_value(as_number(left) / as_number(right));
         }
 
         case MOD: {
-            if (!check_number_operands(NUMBER, 2, left, right)) {
-                if (left.type == NUMBER_2) free(left.string);
-                if (right.type == NUMBER_2) free(right.string);
-                runtime_error(expr->binary->Operator,
+            if (!is_number(left) || !is_number(right)) {
+                runtime_error(offset,
                               "Runtime: Operands must be numbers",
                               had_runtime_error);
-                return (Object){ .type = INVALID_TOKEN_INT };
+                return invalid_value();
             }
-            if (is_floating_almost_equal(right.number, 0.0f)) {
-                if (left.type == NUMBER_2) free(left.string);
-                if (right.type == NUMBER_2) free(right.string);
-                runtime_error(expr->binary->Operator,
+            if (is_floating_almost_equal(as_number(right), 0.0f)) {
+                runtime_error(offset,
                               "Runtime: Division by zero is not allowed.",
                               had_runtime_error);
-                return (Object){ .type = INVALID_TOKEN_INT };
+                return invalid_value();
             }
-            if (left.type == NUMBER_2) free(left.string);
-            if (right.type == NUMBER_2) free(right.string);
-            char* str = calloc(DOUBLE_MAX_DIG + 1, sizeof(char));
-            snprintf(str, DOUBLE_MAX_DIG, "%lf", fmod(left.number, right.number));
-            return (Object){ .number = fmod(left.number, right.number),
-                             .string = str,
-                             .string_len = strlen(str),
-                             .type = NUMBER_2 };
+            return number_value(fmod(as_number(left), as_number(right)));
         }
 
         case STAR: {
-            if (!check_number_operands(NUMBER, 2, left, right)) {
-                if (left.type == NUMBER_2) free(left.string);
-                if (right.type == NUMBER_2) free(right.string);
-                runtime_error(expr->binary->Operator,
+            if (!is_number(left) || !is_number(right)) {
+                runtime_error(offset,
                               "Runtime: Operands must be numbers",
                               had_runtime_error);
-                return (Object){ .type = INVALID_TOKEN_INT };
+                return invalid_value();
             }
-            if (left.type == NUMBER_2) free(left.string);
-            if (right.type == NUMBER_2) free(right.string);
-            char* str = calloc(DOUBLE_MAX_DIG + 1, sizeof(char));
-            snprintf(str, DOUBLE_MAX_DIG, "%lf", left.number * right.number);
-            return (Object){ .number = left.number * right.number,
-                             .string = str,
-                             .string_len = strlen(str),
-                             .type = NUMBER_2 };
+            return number_value(as_number(left) * as_number(right));
         }
 
         case GREATER: {
-            if (!check_number_operands(NUMBER, 2, left, right)) {
-                if (left.type == NUMBER_2) free(left.string);
-                if (right.type == NUMBER_2) free(right.string);
-                runtime_error(expr->binary->Operator,
+            if (!is_number(left) || !is_number(right)) {
+                runtime_error(offset,
                               "Runtime: Operands must be numbers",
                               had_runtime_error);
-                return (Object){ .type = INVALID_TOKEN_INT };
+                return invalid_value();
             }
-            bool what = isgreater(left.number, right.number);
-            return (Object){ .boolean = what, .type = boolean_type(what) };
+            return bool_value(isgreater(as_number(left), as_number(right)));
         }
         case GREATER_EQUAL: {
-            if (!check_number_operands(NUMBER, 2, left, right)) {
-                if (left.type == NUMBER_2) free(left.string);
-                if (right.type == NUMBER_2) free(right.string);
-                runtime_error(expr->binary->Operator,
+            if (!is_number(left) || !is_number(right)) {
+                runtime_error(offset,
                               "Runtime: Operands must be numbers",
                               had_runtime_error);
-                return (Object){ .type = INVALID_TOKEN_INT };
+                return invalid_value();
             }
-            bool what = isgreaterequal(left.number, right.number);
-            return (Object){ .boolean = what, .type = boolean_type(what) };
+            return bool_value(isgreaterequal(as_number(left), as_number(right)));
         }
         case LESS: {
-            if (!check_number_operands(NUMBER, 2, left, right)) {
-                if (left.type == NUMBER_2) free(left.string);
-                if (right.type == NUMBER_2) free(right.string);
-                runtime_error(expr->binary->Operator,
+            if (!is_number(left) || !is_number(right)) {
+                runtime_error(offset,
                               "Runtime: Operands must be numbers",
                               had_runtime_error);
-                return (Object){ .type = INVALID_TOKEN_INT };
+                return invalid_value();
             }
-            bool what = isless(left.number, right.number);
-            return (Object){ .boolean = what, .type = boolean_type(what) };
+            return bool_value(isless(as_number(left), as_number(right)));
         }
         case LESS_EQUAL: {
-            if (!check_number_operands(NUMBER, 2, left, right)) {
-                if (left.type == NUMBER_2) free(left.string);
-                if (right.type == NUMBER_2) free(right.string);
-                runtime_error(expr->binary->Operator,
+            if (!is_number(left) || !is_number(right)) {
+                runtime_error(offset,
                               "Runtime: Operands must be numbers",
                               had_runtime_error);
-                return (Object){ .type = INVALID_TOKEN_INT };
+                return invalid_value();
             }
-            bool what = islessequal(left.number, right.number);
-            return (Object){ .boolean = what, .type = boolean_type(what) };
-        }
-        case BANG_EQUAL: {
-            bool what = !is_equal(left, right);
-            return (Object){ .boolean = what, .type = boolean_type(what) };
-        }
-        case EQUAL_EQUAL: {
-            bool what = is_equal(left, right);
-            return (Object){ .boolean = what, .type = boolean_type(what) };
+            return bool_value(islessequal(as_number(left), as_number(right)));
         }
+        case BANG_EQUAL:
+            return bool_value(!is_equal(left, right));
+        case EQUAL_EQUAL:
+            return bool_value(is_equal(left, right));
         default:
-            return (Object){ .type = INVALID_TOKEN_INT };
+            return invalid_value();
     }
 
     __builtin_unreachable();
-    return (Object){ .type = INVALID_TOKEN_INT };
+    return invalid_value();
 }
 
-Object
-evaluate_identifier(Env_manager* env_mgr, Expr* expr)
+static Value
+evaluate_binary(Env_manager* env_mgr,
+                const Expr_pool* exprs,
+                Expr_idx expr,
+                bool* had_runtime_error)
 {
-    return get_value(env_mgr, expr->literal->value, env_mgr->env_idx);
+    const Expr_node* binary = expr_node(exprs, expr);
+    Value left = evaluate(env_mgr, exprs, binary->left, had_runtime_error);
+    Value right = evaluate(env_mgr, exprs, binary->right, had_runtime_error);
+
+    Value result = binary_operation(
+      binary->token, binary->offset, left, right, had_runtime_error);
+    release_value(left);
+    release_value(right);
+    return result;
 }
 
-static Object
-evaluate_assignment(Env_manager* env_mgr, Expr* expr, bool* had_runtime_error)
+/* the variable was resolved to the scope and slot it is in */
+Value
+evaluate_identifier(Env_manager* env_mgr, const Expr_pool* exprs, Expr_idx expr)
 {
-    Object value = evaluate(env_mgr, expr->variable->value, had_runtime_error);
-    if (value.type != INVALID_TOKEN_INT)
-        assign(env_mgr, expr->variable->name, value, env_mgr->env_idx);
-    else {
-        value = (Object){ .string = expr->variable->name.lexeme,
-                          .string_len = expr->variable->name.lexeme_len,
-                          .type = IDENTIFIER };
-    }
+    const Expr_node* node = expr_node(exprs, expr);
+    return retain_value(get_value(env_mgr, node->depth, node->slot));
+}
+
+static Value
+evaluate_assignment(Env_manager* env_mgr,
+                    const Expr_pool* exprs,
+                    Expr_idx expr,
+                    bool* had_runtime_error)
+{
+    const Expr_node* variable = expr_node(exprs, expr);
+    Value value = evaluate(env_mgr, exprs, variable->right, had_runtime_error);
+    /* the variable and the caller both hold the value */
+    if (!is_invalid(value))
+        assign(env_mgr, variable->depth, variable->slot, retain_value(value));
+
     return value;
 }
 
-Object
-evaluate(Env_manager* env_mgr, Expr* expr, bool* had_runtime_error)
+/* evaluate an expression, the tree is walked by the indices of the nodes
+ * Params:
+ * @env_mgr : the environments
+ * @exprs : the expression pool the expression is in
+ * @expr : the index of the expression, NO_EXPR gives the invalid value
+ * @had_runtime_error : set when a runtime error is reported
+ * Ret:
+ * @Value : the value of the expression, the caller owns a reference to it
+ *          and releases it with release_value()
+ */
+Value
+evaluate(Env_manager* env_mgr,
+         const Expr_pool* exprs,
+         Expr_idx expr,
+         bool* had_runtime_error)
 {
-    if (expr == NULL) return (Object){ .type = INVALID_TOKEN_INT };
-    switch (expr->type) {
+    if (expr == NO_EXPR) return invalid_value();
+    switch (expr_node(exprs, expr)->type) {
         case LITERAL:
-            return evaluate_literal(env_mgr, expr);
+            return evaluate_literal(env_mgr, exprs, expr);
         case UNARY:
-            return evaluate_unary(env_mgr, expr, had_runtime_error);
+            return evaluate_unary(env_mgr, exprs, expr, had_runtime_error);
         case GROUPING:
-            return evaluate_group(env_mgr, expr, had_runtime_error);
+            return evaluate_group(env_mgr, exprs, expr, had_runtime_error);
         case BINARY:
-            return evaluate_binary(env_mgr, expr, had_runtime_error);
+            return evaluate_binary(env_mgr, exprs, expr, had_runtime_error);
         case VARIABLE:
-            return evaluate_assignment(env_mgr, expr, had_runtime_error);
+            return evaluate_assignment(env_mgr, exprs, expr, had_runtime_error);
+        /* the parser does not let a program with an invalid
+         * expression through, so this is a bug */
         default:
-            __builtin_unreachable();
+            runtime_error(expr_node(exprs, expr)->offset,
+                          "Runtime: Internal error, invalid expression.",
+                          had_runtime_error);
+            return invalid_value();
     }
 }
 
-static char*
-stringify(Object object)
+/* run a statement, dispatched on its type */
+static void
+execute(Env_manager* env_mgr,
+        const Expr_pool* exprs,
+        Statement statement,
+        bool* had_runtime_error)
 {
-    switch (object.type) {
-        case TRUE:
-            return "true";
-        case FALSE:
-            return "false";
-        case NIL:
-            return "nil";
-        case STRING:
-        case STRING_2:
-        case NUMBER:
-        case NUMBER_2:
-            return object.string;
-        default:
-            __builtin_unreachable();
+    switch (statement.type) {
+        case EXPR_STMT:
+            eval_expr_stmt(env_mgr, exprs, statement, had_runtime_error);
+            break;
+        case PRINT_STMT:
+            eval_print_stmt(env_mgr, exprs, statement, had_runtime_error);
+            break;
+        case VAR_DECL_STMT:
+            eval_var_stmt(env_mgr, exprs, statement, had_runtime_error);
+            break;
+        case IF_STMT:
+            eval_if_stmt(env_mgr, exprs, statement, had_runtime_error);
+            break;
+        case BLOCK_STMT:
+            eval_block(env_mgr, exprs, statement, had_runtime_error);
+            break;
+        case BAD_STMT:
+            break;
     }
 }
 
 void
-eval_expr_stmt(Env_manager* env_mgr, Statement statement, bool* had_runtime_error)
+eval_expr_stmt(Env_manager* env_mgr,
+               const Expr_pool* exprs,
+               Statement statement,
+               bool* had_runtime_error)
 {
-    evaluate(env_mgr, statement.exStmt.expression, had_runtime_error);
+    release_value(
+      evaluate(env_mgr, exprs, statement.exStmt.expression, had_runtime_error));
 }
 
 void
-eval_print_stmt(Env_manager* env_mgr, Statement statement, bool* had_runtime_error)
+eval_print_stmt(Env_manager* env_mgr,
+                const Expr_pool* exprs,
+                Statement statement,
+                bool* had_runtime_error)
 {
-    char* str = NULL;
-    Object obj = evaluate(env_mgr, statement.prtStmt.expression, had_runtime_error);
-    if (obj.type == INVALID_TOKEN_INT) return;
-
-    str = stringify(obj);
-    puts(str);
+    Value value =
+      evaluate(env_mgr, exprs, statement.prtStmt.expression, had_runtime_error);
+    print_value(value);
+    release_value(value);
 }
 
 void
-eval_var_stmt(Env_manager* env_mgr, Statement statement, bool* had_runtime_error)
+eval_var_stmt(Env_manager* env_mgr,
+              const Expr_pool* exprs,
+              Statement statement,
+              bool* had_runtime_error)
 {
-    Object obj = { .type = NIL };
-    if (statement.vardecl.expression != NULL)
-        obj = evaluate(env_mgr, statement.vardecl.expression, had_runtime_error);
+    Value value = nil_value();
+    if (statement.vardecl.expression != NO_EXPR)
+        value = evaluate(
+          env_mgr, exprs, statement.vardecl.expression, had_runtime_error);
 
-    define(env_mgr, statement.vardecl.tok.lexeme, obj, env_mgr->env_idx);
-}
-
-static void
-free_block(Statement block)
-{
-    assert(block.type == BLOCK_STMT);
-    size_t cnt = block.block.statements[0].count;
-    for (size_t i = 0; i < cnt; i++) {
-        if (block.block.statements[i].type == IF_STMT) continue;
-        if (block.block.statements[i].type == BLOCK_STMT) continue;
-        deallocate_expr(block.block.statements[i].exStmt.expression);
-    }
-    free(block.block.statements);
+    /* the variable takes over the reference */
+    define(env_mgr, statement.vardecl.slot, value);
 }
 
 void
-eval_if_stmt(Env_manager* env_mgr, Statement statement, bool* had_runtime_error)
+eval_if_stmt(Env_manager* env_mgr,
+             const Expr_pool* exprs,
+             Statement statement,
+             bool* had_runtime_error)
 {
-    if (is_truthy(
-          evaluate(env_mgr, statement.ifStmt.condition, had_runtime_error))) {
-        statement.ifStmt.branches[THEN_BRNCH].accept(
-          env_mgr, statement.ifStmt.branches[THEN_BRNCH], had_runtime_error);
+    Value condition =
+      evaluate(env_mgr, exprs, statement.ifStmt.condition, had_runtime_error);
+    bool truthy = is_truthy(condition);
+    release_value(condition);
+
+    if (truthy) {
+        execute(
+          env_mgr, exprs, statement.ifStmt.branches[THEN_BRNCH], had_runtime_error);
     } else if (statement.ifStmt.branches[ELSE_BRNCH].type != BAD_STMT) {
-        statement.ifStmt.branches[ELSE_BRNCH].accept(
-          env_mgr, statement.ifStmt.branches[ELSE_BRNCH], had_runtime_error);
+        execute(
+          env_mgr, exprs, statement.ifStmt.branches[ELSE_BRNCH], had_runtime_error);
     }
-
-    deallocate_expr(statement.ifStmt.condition);
-
-    switch (statement.ifStmt.ran) {
-        case THEN_BRNCH:
-            if (statement.ifStmt.branches[ELSE_BRNCH].type == BLOCK_STMT) {
-                shfree(env_mgr->envs[env_mgr->env_idx]);
-                env_mgr->env_idx--;
-                free_block(statement.ifStmt.branches[ELSE_BRNCH]);
-            }
-            break;
-        case ELSE_BRNCH:
-            if (statement.ifStmt.branches[THEN_BRNCH].type == BLOCK_STMT) {
-                shfree(env_mgr->envs[env_mgr->env_idx]);
-                env_mgr->env_idx--;
-                free_block(statement.ifStmt.branches[THEN_BRNCH]);
-            }
-            break;
-    }
-    if (statement.ifStmt.branches[THEN_BRNCH].type != BLOCK_STMT &&
-        statement.ifStmt.branches[THEN_BRNCH].type != IF_STMT)
-        deallocate_expr(statement.ifStmt.branches[THEN_BRNCH].exStmt.expression);
-    if (statement.ifStmt.branches[ELSE_BRNCH].type != BAD_STMT &&
-        statement.ifStmt.branches[ELSE_BRNCH].type != BLOCK_STMT &&
-        statement.ifStmt.branches[ELSE_BRNCH].type != IF_STMT)
-        deallocate_expr(statement.ifStmt.branches[ELSE_BRNCH].exStmt.expression);
-
-    free(statement.ifStmt.branches);
 }
 
 void
-eval_block(Env_manager* env_mgr, Statement statement, bool* had_runtime_error)
+eval_block(Env_manager* env_mgr,
+           const Expr_pool* exprs,
+           Statement statement,
+           bool* had_runtime_error)
 {
-    Statement* block = statement.block.statements;
+    const Statement* block = statement.block.statements;
     size_t cnt = block[0].count;
 
+    /* every run of the block gets a fresh environment */
+    push_env(env_mgr, statement.block.slot_cnt);
     for (size_t i = 0; i < cnt; i++) {
-        block[i].accept(env_mgr, block[i], had_runtime_error);
+        execute(env_mgr, exprs, block[i], had_runtime_error);
     }
-
-    shfree(env_mgr->envs[env_mgr->env_idx]);
-    env_mgr->env_idx--;
-    free_block(statement);
+    pop_env(env_mgr);
 }
 
+/* run the statements of a program, the AST is left untouched
+ * so a parsed program can be run as often as needed
+ * Params:
+ * @program : the program, parsed and resolved without errors
+ */
 void
 interpret(Program* program)
 {
+    reserve_globals(program->env_mgr, hmlenu(program->globals));
+
     for (size_t i = 0; i < program->statements[0].count; i++) {
-        program->statements[i].accept(
-          program->env_mgr, program->statements[i], &program->had_runtime_error);
+        execute(program->env_mgr,
+                &program->exprs,
+                program->statements[i],
+                &program->had_runtime_error);
     }
 }
@@ -22,25 +22,72 @@
 #define CLOX_BASIC_EVALUATOR_H
 
 #include "environment.h"
+#include "expr_pool.h"
+#include "value.h"
 #include <stdbool.h>
+#include <stdint.h>
 
-Object
-evaluate(Env_manager* env_mgr, Expr* expr, bool* had_runtime_error);
+/* whether the == operator holds for two values */
+bool
+is_equal(Value a, Value b);
+
+/* whether a value counts as true in a condition */
+bool
+is_truthy(Value value);
+
+/* print a value on its own line, the invalid value prints nothing */
+void
+print_value(Value value);
+
+/* apply the unary operator 'op' to a borrowed operand, errors are reported
+ * at 'offset' in the source and give the invalid value */
+Value
+unary_operation(uint8_t op, uint32_t offset, Value right, bool* had_runtime_error);
+
+/* apply the binary operator 'op' to borrowed operands, errors are reported
+ * at 'offset' in the source and give the invalid value */
+Value
+binary_operation(uint8_t op,
+                 uint32_t offset,
+                 Value left,
+                 Value right,
+                 bool* had_runtime_error);
+
+Value
+evaluate(Env_manager* env_mgr,
+         const Expr_pool* exprs,
+         Expr_idx expr,
+         bool* had_runtime_error);
 
 void
-eval_expr_stmt(Env_manager* env_mgr, Statement statement, bool* had_runtime_error);
+eval_expr_stmt(Env_manager* env_mgr,
+               const Expr_pool* exprs,
+               Statement statement,
+               bool* had_runtime_error);
 
 void
-eval_print_stmt(Env_manager* env_mgr, Statement statement, bool* had_runtime_error);
+eval_print_stmt(Env_manager* env_mgr,
+                const Expr_pool* exprs,
+                Statement statement,
+                bool* had_runtime_error);
 
 void
-eval_var_stmt(Env_manager* env_mgr, Statement statement, bool* had_runtime_error);
+eval_var_stmt(Env_manager* env_mgr,
+              const Expr_pool* exprs,
+              Statement statement,
+              bool* had_runtime_error);
 
 void
-eval_if_stmt(Env_manager* env_mgr, Statement statement, bool* had_runtime_error);
+eval_if_stmt(Env_manager* env_mgr,
+             const Expr_pool* exprs,
+             Statement statement,
+             bool* had_runtime_error);
 
 void
-eval_block(Env_manager* env_mgr, Statement statement, bool* had_runtime_error);
+eval_block(Env_manager* env_mgr,
+           const Expr_pool* exprs,
+           Statement statement,
+           bool* had_runtime_error);
 
 void
 interpret(Program* program);
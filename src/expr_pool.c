@@ -0,0 +1,142 @@
+// clox-basic - C Language Implementation of jlox from Crafting Interpreters.
+//
+// Copyright (C) 2022 Amritpal Singh
+//
+// This file is part of clox-basic.
+//
+// clox-basic is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3
+// of the License, or (at your option) any later version.
+//
+// clox-basic is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied
+// warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// clox-basic. If not, see <https://www.gnu.org/licenses/>.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sysexits.h>
+
+#include "expr_pool.h"
+#include "token.h"
+#include "utility.h"
+
+/* number of nodes the pool starts out with */
+enum { EXPR_POOL_MIN = 256 };
+
+/* initialise an empty expression pool, the nodes are allocated on first use
+ * Ret:
+ * @Expr_pool : the expression pool
+ */
+Expr_pool
+init_expr_pool(void)
+{
+    return (Expr_pool){ 0 };
+}
+
+/* append a node to the pool, the array grows geometrically
+ * Params:
+ * @pool : the expression pool
+ * @node : the node to be appended
+ * Ret:
+ * @Expr_idx : the index of the node in the pool
+ */
+Expr_idx
+push_expr(Expr_pool* pool, Expr_node node)
+{
+    if (pool->count == pool->capacity) {
+        size_t capacity = pool->capacity ? pool->capacity * 2 : EXPR_POOL_MIN;
+        Expr_node* nodes = realloc(pool->nodes, capacity * sizeof(Expr_node));
+        if (nodes == NULL || capacity >= NO_EXPR) {
+            error(NO_SOURCE_OFFSET,
+                  "Out of memory while growing the expression pool");
+            exit(EX_OSERR);
+        }
+#ifdef CLOX_LOG_ALLOCATIONS
+        printf("Growing the expression pool to %zu nodes\n", capacity);
+#endif
+        pool->nodes = nodes;
+        pool->capacity = capacity;
+    }
+
+    pool->nodes[pool->count] = node;
+    return pool->count++;
+}
+
+/* make a node for an expression, NUMBER literals keep their value and
+ * identifiers and strings their interned copy
+ * Params:
+ * @type : the type of the expression
+ * @token : the token the expression is made from
+ * @left : index of the left child or NO_EXPR
+ * @right : index of the right child or NO_EXPR
+ * Ret:
+ * @Expr_node : the node, not yet in any pool
+ */
+Expr_node
+init_expr_node(enum EXPR_TYPES type, Token token, Expr_idx left, Expr_idx right)
+{
+    Expr_node node = { .offset = token.offset,
+                       .len = token.lexeme_len,
+                       .left = left,
+                       .right = right,
+                       .type = type,
+                       .token = token.type };
+
+    if (token.type == NUMBER)
+        node.number = token.num_literal;
+    else
+        node.interned = token.interned;
+
+    return node;
+}
+
+/* materialise the token of a node, its lexeme points into the source
+ * Params:
+ * @pool : the expression pool
+ * @idx : the index of the node
+ * Ret:
+ * @Token : the token the node was made from
+ */
+Token
+expr_token(const Expr_pool* pool, Expr_idx idx)
+{
+    const Expr_node* node = expr_node(pool, idx);
+    Token token = init_tok(node->token,
+                           pool->source + node->offset,
+                           node->offset,
+                           node->len,
+                           node->token == NUMBER ? node->number : 0);
+    if (node->token != NUMBER) token.interned = node->interned;
+
+    return token;
+}
+
+/* drop every node of the pool, the nodes that follow are made from source
+ * Params:
+ * @pool : the expression pool
+ * @source : the source of the next program
+ */
+void
+reset_expr_pool(Expr_pool* pool, const char* source)
+{
+    pool->source = source;
+    pool->count = 0;
+}
+
+/* free() the nodes of the pool
+ * Params:
+ * @pool : the expression pool
+ */
+void
+deallocate_expr_pool(Expr_pool* pool)
+{
+    free(pool->nodes);
+    *pool = init_expr_pool();
+}
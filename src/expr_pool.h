@@ -0,0 +1,113 @@
+#pragma once
+// clox-basic - C Language Implementation of jlox from Crafting Interpreters.
+//
+// Copyright (C) 2022 Amritpal Singh
+//
+// This file is part of clox-basic.
+//
+// clox-basic is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3
+// of the License, or (at your option) any later version.
+//
+// clox-basic is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied
+// warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// clox-basic. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef CLOX_BASIC_EXPR_POOL_H
+#define CLOX_BASIC_EXPR_POOL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "intern.h"
+#include "token.h"
+
+/* expressions refer to each other by their index in the pool */
+typedef uint32_t Expr_idx;
+
+/* index of a missing expression, e.g. a variable declared without an
+ * initialiser */
+#define NO_EXPR UINT32_MAX
+
+enum EXPR_TYPES { LITERAL, UNARY, BINARY, GROUPING, VARIABLE, INVALID_EXPR_INT };
+
+/* a node of the expression tree, tagged by 'type'.
+ * The token a node was made from is kept as its type and the offset and
+ * length of its lexeme, so the source must be smaller than 4 GiB.
+ * Which fields are used depends on the type:
+ *  LITERAL  : 'token', the literal or identifier, 'number' or 'interned'
+ *  UNARY    : 'token', the operator, operand in 'right'
+ *  BINARY   : 'token', the operator, operands in 'left' and 'right'
+ *  GROUPING : the grouped expression in 'left'
+ *  VARIABLE : 'token' and 'interned', the name, assigned value in 'right'
+ * Identifiers and VARIABLE nodes get the 'depth' and 'slot' of the variable
+ * from resolve(), which runs last as 'depth' shares its place with 'left' */
+typedef struct Expr_node {
+    union {
+        double number;
+        const Interned_string* interned;
+    };
+    uint32_t offset;
+    uint32_t len;
+    union {
+        Expr_idx left;
+        /* how many scopes out from the use the variable is declared */
+        uint32_t depth;
+    };
+    Expr_idx right;
+    uint8_t type;
+    uint8_t token;
+    /* a binary expression whose left operand is a binary of the same rule */
+    bool nests;
+    /* the index of the variable in the scope it is declared in */
+    uint32_t slot;
+} Expr_node;
+
+/* every expression of a program in one array, children are
+ * always pushed before their parents */
+typedef struct Expr_pool {
+    /* the source the lexemes of the nodes are in */
+    const char* source;
+    Expr_node* nodes;
+    size_t count;
+    size_t capacity;
+} Expr_pool;
+
+/* initialise an empty expression pool */
+Expr_pool
+init_expr_pool(void);
+
+/* append a node to the pool and return its index */
+Expr_idx
+push_expr(Expr_pool* pool, Expr_node node);
+
+/* a node for the expression made from token */
+Expr_node
+init_expr_node(enum EXPR_TYPES type, Token token, Expr_idx left, Expr_idx right);
+
+/* materialise the token an expression was made from */
+Token
+expr_token(const Expr_pool* pool, Expr_idx idx);
+
+/* drop every node, the memory is kept for the next program */
+void
+reset_expr_pool(Expr_pool* pool, const char* source);
+
+/* free() the nodes of the pool */
+void
+deallocate_expr_pool(Expr_pool* pool);
+
+/* the idx'th node of the pool */
+static inline const Expr_node*
+expr_node(const Expr_pool* pool, Expr_idx idx)
+{
+    return &pool->nodes[idx];
+}
+
+#endif
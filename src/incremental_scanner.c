@@ -0,0 +1,212 @@
+// clox-basic - C Language Implementation of jlox from Crafting Interpreters.
+//
+// Copyright (C) 2022 Amritpal Singh
+//
+// This file is part of clox-basic.
+//
+// clox-basic is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3
+// of the License, or (at your option) any later version.
+//
+// clox-basic is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied
+// warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// clox-basic. If not, see <https://www.gnu.org/licenses/>.
+
+/* incremental scanning after an edit. A token is only reused as is when it
+ * ends, including the lookahead the lexer cores may have used, before the
+ * edit. Scanning restarts at the end of the last such token, where the lexer
+ * is outside of strings and comments, and stops as soon as a new token starts
+ * after the edit exactly where an old token started, shifted by the change
+ * in length. From there the source is the same as before so the rest of the
+ * old tokens are reused with their offsets shifted. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sysexits.h>
+
+#include "incremental_scanner.h"
+#include "scanner.h"
+#include "token.h"
+#include "utility.h"
+
+/* bytes past the end of a token the lexer cores may look at, the '.' and
+ * the digit after a number */
+#define TOKEN_LOOKAHEAD 2
+
+/* the lexeme of a string token does not include its quotes */
+static size_t
+token_start(Token token)
+{
+    return token.type == STRING ? token.offset - 1 : token.offset;
+}
+
+static size_t
+token_end(Token token)
+{
+    size_t end = token.offset + token.lexeme_len;
+    return token.type == STRING ? end + 1 : end;
+}
+
+/* make sure the token buffer can hold 'count' tokens
+ * Params:
+ * @scanner : the scanner structure
+ * @count : the number of tokens needed
+ */
+static void
+reserve_tokens(Scanner* scanner, size_t count)
+{
+    if (count <= scanner->token_max) return;
+
+    size_t capacity = scanner->token_max * 2;
+    if (capacity < count) capacity = count;
+
+    extend_tokens_by(
+      &scanner->tokens, scanner->token_max, capacity - scanner->token_max);
+    if (scanner->tokens == NULL) {
+        error(NO_SOURCE_OFFSET, "Out of memory while rescanning tokens");
+        exit(EX_OSERR);
+    }
+
+    scanner->token_max = capacity;
+    scanner->stats.reallocs++;
+    scanner->stats.peak_capacity = capacity;
+}
+
+/* number of old tokens that can be reused in front of the edit
+ * Params:
+ * @tokens : the old tokens
+ * @count : number of old tokens, without ENDOF
+ * @edit_start : where the edit starts
+ * Ret:
+ * @size_t : index of the first token that has to be scanned again
+ */
+static size_t
+reusable_prefix(const Token* tokens, size_t count, size_t edit_start)
+{
+    size_t low = 0;
+    size_t high = count;
+
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        if (token_end(tokens[mid]) + TOKEN_LOOKAHEAD <= edit_start) low = mid + 1;
+        else
+            high = mid;
+    }
+
+    return low;
+}
+
+/* scan the tokens of the edited source again, starting at the first token
+ * that may have been changed by the edit and stopping once the new tokens
+ * line up with the old ones again
+ * Params:
+ * @scanner : the scanner structure, its token buffer holds the tokens of
+ *            the source before the edit
+ * @source : the edited source
+ * @source_length : length of the edited source
+ * @edit : the edit that turned the old source into the new one
+ * Ret:
+ * @Token* : A pointer to all the tokens of the edited source
+ */
+Token*
+rescan_tokens(Scanner* scanner,
+              const char* source,
+              size_t source_length,
+              Source_edit edit)
+{
+    const char* old_source = scanner->source;
+    size_t old_count = scanner->tokens_count;
+    size_t first = reusable_prefix(scanner->tokens, old_count, edit.start);
+    size_t edit_end = edit.start + edit.new_len;
+
+    Scanner rescanner = init_scanner(source, source_length);
+    rescanner.lexer = scanner->lexer;
+    rescanner.strings = scanner->strings;
+    rescanner.quiet = scanner->quiet;
+    rescanner.current = first > 0 ? token_end(scanner->tokens[first - 1]) : 0;
+
+    /* the new tokens up to the point where the old ones are reused */
+    Token* fresh = NULL;
+    size_t fresh_count = 0;
+    size_t fresh_max = 0;
+
+    /* the old token the stream resynchronises on, old_count + 1 if none */
+    size_t resync = first;
+    Token token;
+
+    for (;;) {
+        token = scanner_next_token(&rescanner);
+        if (token.type == ENDOF) {
+            resync = old_count + 1;
+            break;
+        }
+
+        size_t start = token_start(token);
+        if (start >= edit_end) {
+            /* both sides shifted by the edit, so they compare without
+             * going negative */
+            while (resync < old_count &&
+                   token_start(scanner->tokens[resync]) + edit.new_len <
+                     start + edit.old_len)
+                resync++;
+
+            if (resync < old_count &&
+                token_start(scanner->tokens[resync]) + edit.new_len ==
+                  start + edit.old_len)
+                break;
+        }
+
+        if (fresh_count == fresh_max) {
+            fresh_max = fresh_max ? fresh_max * 2 : TOKEN_CNT;
+            extend_tokens_by(&fresh, fresh_count, fresh_max - fresh_count);
+        }
+        fresh[fresh_count++] = token;
+    }
+
+    /* the reused tail includes the old ENDOF token */
+    size_t tail = resync <= old_count ? old_count + 1 - resync : 0;
+    size_t count = first + fresh_count + tail;
+    if (tail == 0) count++;
+
+    reserve_tokens(scanner, count);
+    Token* tokens = scanner->tokens;
+
+    if (first + fresh_count != resync)
+        memmove(tokens + first + fresh_count, tokens + resync, tail * sizeof(Token));
+    if (fresh_count > 0)
+        memcpy(tokens + first, fresh, fresh_count * sizeof(Token));
+    deallocate_tokens(fresh);
+
+    if (tail == 0) tokens[count - 1] = token;
+
+    /* the lexemes are views into the source, move them to the new one. An
+     * edit of the same length made in place leaves the old tokens as is */
+    if (source != old_source) {
+        for (size_t i = 0; i < first; i++)
+            tokens[i].lexeme = source + tokens[i].offset;
+    }
+
+    bool shifted = source != old_source || edit.old_len != edit.new_len;
+    if (tail > 0 && shifted) {
+        for (size_t i = first + fresh_count; i < count; i++) {
+            tokens[i].offset = tokens[i].offset - edit.old_len + edit.new_len;
+            tokens[i].lexeme =
+              tokens[i].type == ENDOF ? "" : source + tokens[i].offset;
+        }
+    }
+
+    scanner->source = source;
+    scanner->source_length = source_length;
+    scanner->tokens_count = count - 1;
+    scanner->start = scanner->current = source_length;
+    scanner->token = tokens[count - 1];
+    scanner->have_token = true;
+    return tokens;
+}
\ No newline at end of file
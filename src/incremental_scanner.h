@@ -0,0 +1,46 @@
+#pragma once
+// clox-basic - C Language Implementation of jlox from Crafting Interpreters.
+//
+// Copyright (C) 2022 Amritpal Singh
+//
+// This file is part of clox-basic.
+//
+// clox-basic is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3
+// of the License, or (at your option) any later version.
+//
+// clox-basic is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied
+// warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// clox-basic. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef CLOX_BASIC_INCREMENTAL_SCANNER_H
+#define CLOX_BASIC_INCREMENTAL_SCANNER_H
+
+#include <stddef.h>
+
+#include "scanner.h"
+#include "token.h"
+
+/* an edit of the source, 'old_len' bytes at 'start' were replaced by
+ * 'new_len' bytes */
+typedef struct Source_edit {
+    size_t start;
+    size_t old_len;
+    size_t new_len;
+} Source_edit;
+
+/* update the scanner's token buffer, filled by scan_tokens() for the source
+ * before the edit, to the tokens of the edited source. Only the tokens
+ * around the edit are scanned again */
+Token*
+rescan_tokens(Scanner* scanner,
+              const char* source,
+              size_t source_length,
+              Source_edit edit);
+
+#endif
\ No newline at end of file
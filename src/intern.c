@@ -0,0 +1,170 @@
+// clox-basic - C Language Implementation of jlox from Crafting Interpreters.
+//
+// Copyright (C) 2022 Amritpal Singh
+//
+// This file is part of clox-basic.
+//
+// clox-basic is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3
+// of the License, or (at your option) any later version.
+//
+// clox-basic is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied
+// warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// clox-basic. If not, see <https://www.gnu.org/licenses/>.
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sysexits.h>
+
+#include "intern.h"
+#include "token.h"
+#include "utility.h"
+
+/* the table starts with this many slots and is kept at most 3/4 full */
+enum { INTERN_MIN_CAPACITY = 64 };
+
+/* allocate memory for the intern table, exit if we are out of memory */
+static void*
+intern_alloc(size_t size)
+{
+    void* memory = calloc(1, size);
+    if (memory == NULL) {
+        error(NO_SOURCE_OFFSET, "Out of memory while interning strings");
+        exit(EX_OSERR);
+    }
+    return memory;
+}
+
+/* initialise an empty intern table, no memory is allocated until the first
+ * string is interned
+ * Ret:
+ * @Intern_table : the intern table
+ */
+Intern_table
+init_intern_table(void)
+{
+    return (Intern_table){ 0 };
+}
+
+/* hash a string with 32-bit FNV-1a
+ * Params:
+ * @chars : the string, need not be null-terminated
+ * @len : length of the string
+ * Ret:
+ * @uint32_t : the hash
+ */
+uint32_t
+hash_string(const char* chars, size_t len)
+{
+    uint32_t hash = 2166136261u;
+
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (uint8_t)chars[i];
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+/* finds the slot of a string, either the one holding it or the empty slot
+ * where it belongs
+ * Params:
+ * @entries : the slots of the table
+ * @capacity : number of slots, a power of two
+ * @chars : the string
+ * @len : length of the string
+ * @hash : hash of the string
+ * Ret:
+ * @Interned_string** : the slot
+ */
+static Interned_string**
+find_slot(Interned_string** entries,
+          size_t capacity,
+          const char* chars,
+          size_t len,
+          uint32_t hash)
+{
+    size_t idx = hash & (capacity - 1);
+
+    for (;;) {
+        Interned_string* entry = entries[idx];
+        if (entry == NULL) return &entries[idx];
+
+        if (entry->hash == hash && entry->len == len &&
+            memcmp(entry->chars, chars, len) == 0)
+            return &entries[idx];
+
+        idx = (idx + 1) & (capacity - 1);
+    }
+}
+
+/* doubles the number of slots, the cached hashes are reused
+ * Params:
+ * @table : the intern table
+ */
+static void
+grow_table(Intern_table* table)
+{
+    size_t capacity = table->capacity ? table->capacity * 2 : INTERN_MIN_CAPACITY;
+    Interned_string** entries = intern_alloc(capacity * sizeof(Interned_string*));
+
+    for (size_t i = 0; i < table->capacity; i++) {
+        Interned_string* entry = table->entries[i];
+        if (entry == NULL) continue;
+        *find_slot(entries, capacity, entry->chars, entry->len, entry->hash) =
+          entry;
+    }
+
+    free(table->entries);
+    table->entries = entries;
+    table->capacity = capacity;
+}
+
+/* get the interned copy of a string, copying it into the table the first
+ * time it is seen
+ * Params:
+ * @table : the intern table
+ * @chars : the string, need not be null-terminated
+ * @len : length of the string
+ * Ret:
+ * @const Interned_string* : the unique interned string, valid until the
+ *                           table is deallocated
+ */
+const Interned_string*
+intern_string(Intern_table* table, const char* chars, size_t len)
+{
+    if ((table->count + 1) * 4 > table->capacity * 3) grow_table(table);
+
+    uint32_t hash = hash_string(chars, len);
+    Interned_string** slot =
+      find_slot(table->entries, table->capacity, chars, len, hash);
+    if (*slot != NULL) return *slot;
+
+    Interned_string* entry = intern_alloc(sizeof(Interned_string) + len + 1);
+    entry->obj.type = OBJ_INTERNED;
+    entry->hash = hash;
+    entry->len = len;
+    memcpy(entry->chars, chars, len);
+    entry->chars[len] = '\0';
+
+    table->count++;
+    return *slot = entry;
+}
+
+/* free() the table and every string interned in it
+ * Params:
+ * @table : the intern table
+ */
+void
+deallocate_intern_table(Intern_table* table)
+{
+    for (size_t i = 0; i < table->capacity; i++) free(table->entries[i]);
+    free(table->entries);
+    *table = init_intern_table();
+}
\ No newline at end of file
@@ -0,0 +1,57 @@
+#pragma once
+// clox-basic - C Language Implementation of jlox from Crafting Interpreters.
+//
+// Copyright (C) 2022 Amritpal Singh
+//
+// This file is part of clox-basic.
+//
+// clox-basic is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3
+// of the License, or (at your option) any later version.
+//
+// clox-basic is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied
+// warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// clox-basic. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef CLOX_BASIC_INTERN_H
+#define CLOX_BASIC_INTERN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "value.h"
+
+/* a unique copy of an identifier or string literal, two interned strings
+ * are equal iff they are the same object. They are string objects, so
+ * string literals are values as they are */
+typedef Obj_string Interned_string;
+
+/* open addressing hash set of interned strings, filled by the scanner */
+typedef struct Intern_table {
+    Interned_string** entries;
+    size_t capacity;
+    size_t count;
+} Intern_table;
+
+/* initialise an empty intern table */
+Intern_table
+init_intern_table(void);
+
+/* FNV-1a hash of the first 'len' characters of chars */
+uint32_t
+hash_string(const char* chars, size_t len);
+
+/* the unique interned copy of the first 'len' characters of chars */
+const Interned_string*
+intern_string(Intern_table* table, const char* chars, size_t len);
+
+/* free() the table and every string interned in it */
+void
+deallocate_intern_table(Intern_table* table);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,244 @@
+// clox-basic - C Language Implementation of jlox from Crafting Interpreters.
+//
+// Copyright (C) 2022 Amritpal Singh
+//
+// This file is part of clox-basic.
+//
+// clox-basic is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3
+// of the License, or (at your option) any later version.
+//
+// clox-basic is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied
+// warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// clox-basic. If not, see <https://www.gnu.org/licenses/>.
+
+/* chunked scanning for large sources. A serial pre-pass walks the source
+ * only as far as it takes to track string literals and comments, and picks
+ * split points at newlines outside of them. No token can cross such a
+ * newline, so every chunk is scanned on its own thread by a scanner that
+ * sees just that chunk, and the chunk token buffers are stitched together
+ * with their offsets moved back to the whole source and their identifiers
+ * and strings interned. */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <threads.h>
+#include <unistd.h>
+
+#include "intern.h"
+#include "parallel_scanner.h"
+#include "scan_simd.h"
+#include "scanner.h"
+#include "token.h"
+
+/* each thread gets at least this much source */
+#define MIN_CHUNK_LEN (256L << 10)
+
+typedef struct Chunk {
+    Scanner scanner;
+    size_t start;
+} Chunk;
+
+/* finds the first newline at or after 'target' that is outside of string
+ * literals and comments, the pre-pass walks the source the same way the
+ * scanner does but only cares about how strings and comments start
+ * Params:
+ * @source : the lox source
+ * @pos : where the pre-pass continues from, must be outside of string
+ *        literals and comments. Updated to the returned split
+ * @target : the offset the split should be at or after
+ * @end : length of the source
+ * Ret:
+ * @size_t : offset of the newline, 'end' if there is none
+ */
+static size_t
+next_split(const char* source, size_t* pos, size_t target, size_t end)
+{
+    size_t i = *pos;
+
+    while (i < end) {
+        char c = source[i];
+
+        if (c == '"') {
+            size_t quote = find_byte(source, i + 1, end, '"');
+            i = quote == end ? end : quote + 1;
+        } else if (c == '/' && i + 1 < end && source[i + 1] == '/') {
+            /* the comment stops at the newline, which may be the split */
+            i = find_byte(source, i + 2, end, '\n');
+        } else if (c == '/' && i + 1 < end && source[i + 1] == '*') {
+            size_t close = find_comment_end(source, i + 2, end);
+            i = close == end ? end : close + 2;
+        } else if (c == '\n' && i >= target) {
+            break;
+        } else {
+            i++;
+        }
+    }
+
+    *pos = i;
+    return i;
+}
+
+/* thread entry, scans a chunk into its own token buffer
+ * Params:
+ * @arg : the Chunk to be scanned
+ * Ret:
+ * @int : always 0
+ */
+static int
+scan_chunk(void* arg)
+{
+    Chunk* chunk = arg;
+    scan_tokens(&chunk->scanner);
+    return 0;
+}
+
+/* scans the whole source on this thread
+ * Params:
+ * @scanner : the scanner structure
+ * Ret:
+ * @Token* : A pointer to all the tokens read
+ */
+static Token*
+scan_ahead(Scanner* scanner)
+{
+    scan_tokens(scanner);
+    scanner->scanned_ahead = true;
+    return scanner->tokens;
+}
+
+/* number of threads to scan with when none is asked for
+ * Ret:
+ * @size_t : the number of online CPUs
+ */
+static size_t
+online_cpus(void)
+{
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return cpus < 1 ? 1 : (size_t)cpus;
+}
+
+bool
+parallel_scan_pays(size_t length)
+{
+    return length >= PARALLEL_SCAN_MIN && online_cpus() > 1;
+}
+
+/* scans all tokens in the lox source code into the scanner's token buffer,
+ * splitting the work across threads when the source is large enough
+ * Params:
+ * @scanner : the scanner structure, nothing must have been scanned yet
+ * @threads : the maximum number of threads, 0 for the number of online CPUs
+ * Ret:
+ * @Token* : A pointer to all the tokens read
+ */
+Token*
+scan_tokens_parallel(Scanner* scanner, size_t threads)
+{
+    const char* source = scanner->source;
+    size_t length = scanner->source_length;
+
+    if (threads == 0) threads = online_cpus();
+    if (threads > length / MIN_CHUNK_LEN) threads = length / MIN_CHUNK_LEN;
+    if (threads < 2) return scan_ahead(scanner);
+
+    Chunk* chunks = calloc(threads, sizeof(Chunk));
+    size_t chunk_cnt = 0;
+    size_t pos = 0;
+
+    for (size_t start = 0; start < length && chunk_cnt < threads; chunk_cnt++) {
+        size_t end = length;
+        if (chunk_cnt + 1 < threads) {
+            size_t target = length / threads * (chunk_cnt + 1);
+            end = next_split(source, &pos, target, length);
+        }
+
+        Scanner* chunk = &chunks[chunk_cnt].scanner;
+        *chunk = init_scanner(source + start, end - start);
+        chunk->lexer = scanner->lexer;
+        chunk->quiet = true;
+        chunks[chunk_cnt].start = start;
+
+        start = end;
+    }
+
+    /* the pre-pass found nowhere to split, e.g. one huge block comment */
+    if (chunk_cnt < 2) {
+        free(chunks);
+        return scan_ahead(scanner);
+    }
+
+    /* the first chunk is scanned on this thread */
+    thrd_t workers[threads];
+    bool started[threads];
+    for (size_t i = 1; i < chunk_cnt; i++) {
+        int rc = thrd_create(&workers[i], scan_chunk, &chunks[i]);
+        started[i] = rc == thrd_success;
+    }
+
+    scan_chunk(&chunks[0]);
+
+    size_t error_cnt = 0;
+    size_t tokens_count = 0;
+    for (size_t i = 0; i < chunk_cnt; i++) {
+        if (i > 0 && started[i]) thrd_join(workers[i], NULL);
+        /* a chunk whose thread could not be started is scanned here */
+        if (i > 0 && !started[i]) scan_chunk(&chunks[i]);
+
+        error_cnt += chunks[i].scanner.error_cnt;
+        tokens_count += chunks[i].scanner.tokens_count;
+    }
+
+    /* errors are rescanned in order so they are reported as usual */
+    if (error_cnt > 0) {
+        for (size_t i = 0; i < chunk_cnt; i++)
+            deallocate_tokens(chunks[i].scanner.tokens);
+        free(chunks);
+
+        return scan_ahead(scanner);
+    }
+
+    /* one more for the ENDOF token */
+    scanner->tokens = allocate_tokens(tokens_count + 1);
+    scanner->token_max = tokens_count + 1;
+    scanner->tokens_count = tokens_count;
+    scanner->stats = (Scanner_stats){ .initial_capacity = tokens_count + 1,
+                                      .peak_capacity = tokens_count + 1 };
+
+    Token* out = scanner->tokens;
+    for (size_t i = 0; i < chunk_cnt; i++) {
+        const Scanner* chunk = &chunks[i].scanner;
+
+        /* the ENDOF token of the last chunk is the one of the source */
+        size_t count = chunk->tokens_count + (i + 1 == chunk_cnt);
+        for (size_t t = 0; t < count; t++) {
+            *out = chunk->tokens[t];
+            out->offset += chunks[i].start;
+
+            /* the table is not shared with the threads, intern in order here */
+            if (scanner->strings != NULL &&
+                (out->type == IDENTIFIER || out->type == STRING))
+                out->interned =
+                  intern_string(scanner->strings, out->lexeme, out->lexeme_len);
+            out++;
+        }
+
+        deallocate_tokens(chunk->tokens);
+    }
+    free(chunks);
+
+    scanner->start = scanner->current = length;
+    scanner->token = scanner->tokens[tokens_count];
+    scanner->have_token = true;
+    scanner->scanned_ahead = true;
+    return scanner->tokens;
+}
\ No newline at end of file
@@ -0,0 +1,47 @@
+#pragma once
+// clox-basic - C Language Implementation of jlox from Crafting Interpreters.
+//
+// Copyright (C) 2022 Amritpal Singh
+//
+// This file is part of clox-basic.
+//
+// clox-basic is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3
+// of the License, or (at your option) any later version.
+//
+// clox-basic is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied
+// warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// clox-basic. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef CLOX_BASIC_PARALLEL_SCANNER_H
+#define CLOX_BASIC_PARALLEL_SCANNER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "scanner.h"
+#include "token.h"
+
+/* sources smaller than this are scanned as the parser goes. Scanning ahead
+ * buffers every token, and the pre-pass, the stitching and the interning in
+ * order are serial, so up to 64 MiB streaming was measured to be faster */
+#define PARALLEL_SCAN_MIN (64L << 20)
+
+/* whether a source of 'length' bytes is worth scanning ahead on several
+ * threads, it needs more than one online CPU and PARALLEL_SCAN_MIN bytes */
+bool
+parallel_scan_pays(size_t length);
+
+/* scan all the tokens into the scanner's token buffer with up to 'threads'
+ * threads (0 picks the number of online CPUs), the tokens are the same as
+ * the ones scan_tokens() produces and the scanner then hands them out from
+ * scanner_next_token() */
+Token*
+scan_tokens_parallel(Scanner* scanner, size_t threads);
+
+#endif
\ No newline at end of file
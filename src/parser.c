@@ -18,17 +18,14 @@
 // clox-basic. If not, see <https://www.gnu.org/licenses/>.
 
 #include <errno.h>
-#include <stdarg.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <sysexits.h>
 
-#include "ast_printer.h"
-#include "environment.h"
-#include "evaluator.h"
+#include "arena.h"
+#include "expr_pool.h"
 #include "parser.h"
 #include "program.h"
 #include "token.h"
@@ -36,197 +33,72 @@
 
 enum { STMT_CNT = 30 };
 
+/* tokens the parser resynchronises on after an error */
+#define STATEMENT_START TOKEN_SET(CLASS, FUN, VAR, FOR, IF, WHILE, PRINT, RET)
+
 /***** parser utility functions *****/
 
-struct Binary_e
-init_binary_expr(Expr* left,
-                 Token Operator,
-                 Expr* right,
-                 void (*visitor)(Env_manager* env_mgr, struct Binary_e*))
+If_stmt
+init_ifStmt(Arena* arena, Expr_idx cond)
 {
-    return (struct Binary_e){ .left = left,
-                              .Operator = Operator,
-                              .right = right,
-                              .accept = visitor,
-                              .nests = false };
+    return (If_stmt){ .branches = arena_alloc(arena, sizeof(Statement) * 2),
+                      .condition = cond };
 }
 
-struct Grouping_e
-init_group_expr(Expr* expression,
-                void (*visitor)(Env_manager* env_mgr, struct Grouping_e*))
+Parser
+init_parser(Scanner* scanner, Arena* arena, Expr_pool* exprs)
 {
-    return (struct Grouping_e){ .expression = expression, .accept = visitor };
+    exprs->source = scanner->source;
+    return (Parser){ .scanner = scanner, .arena = arena, .exprs = exprs };
 }
 
-struct Unary_e
-init_unary_expr(Token Operator,
-                Expr* right,
-                void (*visitor)(Env_manager* env_mgr, struct Unary_e*))
-{
-    return (
-      struct Unary_e){ .Operator = Operator, .right = right, .accept = visitor };
-}
+/***** Parser workers *****/
 
-struct Literal_e
-init_literal_expr(Token token,
-                  void (*visitor)(Env_manager* env_mgr, struct Literal_e*))
-{
-    return (struct Literal_e){ .value = token, .accept = visitor };
-}
+/* forward declaration */
+Expr_idx
+expression_rule(Parser* parser);
 
-struct Variable_e
-init_variable_expr(Token name,
-                   Expr* rvalue,
-                   void (*visitor)(Env_manager* env_mgr, struct Variable_e*))
+/* the slot of the ring buffer holding the token_idx'th token */
+static inline Token*
+lookahead_slot(Parser* parser, size_t token_idx)
 {
-    return (struct Variable_e){ .name = name, .value = rvalue, .accept = visitor };
+    return &parser->lookahead[token_idx & (PARSER_LOOKAHEAD - 1)];
 }
 
-If_stmt
-init_ifStmt(Expr* cond)
-{
-    return (If_stmt){ .branches = malloc(sizeof(Statement) * 2), .condition = cond };
-}
-
-Expr
-init_expression(enum EXPR_TYPES type,
-                void* holder,
-                void (*visitor)(Expr*),
-                Object (*evaluator)(Env_manager* env_mgr, Expr*, bool*))
-{
-    Expr expr = { .type = type, .accept = visitor, .evaluate = evaluator };
-    switch (type) {
-        case LITERAL:
-            expr.literal = holder;
-            return expr;
-        case UNARY:
-            expr.unary = holder;
-            return expr;
-        case BINARY:
-            expr.binary = holder;
-            return expr;
-        case GROUPING:
-            expr.group = holder;
-            return expr;
-        default:
-            return expr;
+/* the slot of the current token, pulled from the scanner if needed */
+static inline Token*
+current_slot(Parser* parser)
+{
+    if (parser->current_token_idx == parser->pulled_token_cnt) {
+        *lookahead_slot(parser, parser->pulled_token_cnt++) =
+          scanner_next_token(parser->scanner);
     }
+    return lookahead_slot(parser, parser->current_token_idx);
 }
 
-Parser
-init_parser(Token* tokens)
+/* the type of the current token, the lookahead probes only need the type */
+static inline enum TOKEN_TYPE
+peek_type(Parser* parser)
 {
-    return (Parser){ .tokens = tokens };
+    return current_slot(parser)->type;
 }
 
-static inline void
-MEM_LOG(enum EXPR_TYPES cond)
-{
-    UNUSED(cond);
-#ifdef CLOX_LOG_ALLOCATIONS
-    switch (cond) {
-        case GROUPING:
-            puts("Deallocating Group Expression");
-            break;
-        case BINARY:
-            puts("Deallocating Binary Expression");
-            break;
-        case UNARY:
-            puts("Deallocating Unary Experssion");
-            break;
-        case LITERAL:
-            puts("Deallocating Literal Expression");
-            break;
-        case VARIABLE:
-            puts("Deallocating Variable RHS expression");
-            break;
-        case INVALID_EXPR_INT:
-            puts("Deallocating Invalid Expression");
-            break;
-    }
-#endif
-}
-
-/* custom allocator - deallocator */
-#define MEM_LOG_ALLOC(T) malloc(sizeof(T))
-
-#ifdef CLOX_LOG_ALLOCATIONS
-#undef MEM_LOG_ALLOC
-#define MEM_LOG_ALLOC(T)                                                            \
-    malloc(sizeof(T));                                                              \
-    puts("Allocating " #T)
-#endif
-
-#define MEM_LOG_DEALLOC(T, x) free(x);
-
-#ifdef CLOX_LOG_ALLOCATIONS
-#undef MEM_LOG_DEALLOC
-#define MEM_LOG_DEALLOC(T, x)                                                       \
-    puts("Deallocating " #T);                                                       \
-    free(x);
-#endif
-
-void
-deallocate_expr(Expr* expr)
-{
-    switch (expr->type) {
-        case GROUPING: {
-            struct Grouping_e* g = expr->group;
-            deallocate_expr(g->expression);
-            MEM_LOG_DEALLOC(struct Grouping_e, g)
-            MEM_LOG(GROUPING);
-            free(expr);
-        } break;
-        case BINARY: {
-            struct Binary_e* b = expr->binary;
-            deallocate_expr(b->left);
-            deallocate_expr(b->right);
-            MEM_LOG_DEALLOC(struct Binary_e, b)
-            MEM_LOG(BINARY);
-            free(expr);
-        } break;
-        case UNARY: {
-            struct Unary_e* u = expr->unary;
-            deallocate_expr(u->right);
-            MEM_LOG_DEALLOC(struct Unary_e, u)
-            MEM_LOG(UNARY);
-            free(expr);
-        } break;
-        case LITERAL: {
-            MEM_LOG_DEALLOC(struct Literal_e, expr->literal);
-            MEM_LOG(LITERAL);
-            free(expr);
-        } break;
-        case VARIABLE: {
-            deallocate_expr(expr->variable->value);
-            MEM_LOG_DEALLOC(struct Variable_e, expr->variable);
-            MEM_LOG(VARIABLE);
-            free(expr);
-            break;
-        }
-        case INVALID_EXPR_INT: {
-            MEM_LOG(INVALID_EXPR_INT);
-            free(expr);
-        }
-    }
+static inline enum TOKEN_TYPE
+previous_type(Parser* parser)
+{
+    return lookahead_slot(parser, parser->current_token_idx - 1)->type;
 }
 
-/***** Parser workers *****/
-
-/* forward declaration */
-Expr*
-expression_rule(Parser* parser);
-
 Token
 peek_token(Parser* parser)
 {
-    return parser->tokens[parser->current_token_idx];
+    return *current_slot(parser);
 }
 
 Token
 previous_token(Parser* parser)
 {
-    return parser->tokens[parser->current_token_idx - 1];
+    return *lookahead_slot(parser, parser->current_token_idx - 1);
 }
 
 static void
@@ -238,15 +110,16 @@ REPORT_PARSER_ERROR_INTERNAL(Token token, const char* message)
         char* buffer = malloc(len + 1);
         snprintf(buffer, len + 1, fmt, message);
 
-        error(token.line, token.col, buffer);
+        error(token.offset, buffer);
         free(buffer);
     } else {
-        const char* fmt = "at '%s' %s";
-        size_t len = snprintf(NULL, 0, fmt, token.lexeme, message);
+        const char* fmt = "at '%.*s' %s";
+        int lexeme_len = (int)token.lexeme_len;
+        size_t len = snprintf(NULL, 0, fmt, lexeme_len, token.lexeme, message);
         char* buffer = malloc(len + 1);
-        snprintf(buffer, len + 1, fmt, token.lexeme, message);
+        snprintf(buffer, len + 1, fmt, lexeme_len, token.lexeme, message);
 
-        error(token.line, token.col, buffer);
+        error(token.offset, buffer);
         free(buffer);
     }
 }
@@ -260,14 +133,20 @@ parser_error(Token token, const char* message)
 bool
 parser_is_at_end(Parser* parser)
 {
-    Token tok = peek_token(parser);
-    return tok.type == ENDOF;
+    return peek_type(parser) == ENDOF;
+}
+
+/* move past the current token without materialising it */
+static inline void
+step_parser(Parser* parser)
+{
+    if (!parser_is_at_end(parser)) parser->current_token_idx++;
 }
 
 Token
 advance_parser(Parser* parser)
 {
-    if (!parser_is_at_end(parser)) parser->current_token_idx++;
+    step_parser(parser);
     return previous_token(parser);
 }
 
@@ -275,52 +154,35 @@ bool
 check_token(Parser* parser, enum TOKEN_TYPE type)
 {
     if (parser_is_at_end(parser)) return false;
-    Token tok = peek_token(parser);
-    return tok.type == type;
+    return peek_type(parser) == type;
 }
 
+/* move past the current token if it is in the set, which must not hold ENDOF */
 bool
-match_token(Parser* parser, size_t token_type_cnt, ...)
+match_token_set(Parser* parser, Token_set set)
 {
-    enum TOKEN_TYPE type;
-    va_list type_list;
-    va_start(type_list, token_type_cnt);
+    if (!token_in_set(set, peek_type(parser))) return false;
 
-    for (size_t i = 0; i < token_type_cnt; i++) {
-        type = va_arg(type_list, enum TOKEN_TYPE);
-        if (check_token(parser, type)) {
-            advance_parser(parser);
-            return true;
-        }
-    }
-    return false;
+    step_parser(parser);
+    return true;
+}
+
+bool
+match_token(Parser* parser, enum TOKEN_TYPE type)
+{
+    return match_token_set(parser, TOKEN_BIT(type));
 }
 
 void
 synchronize_parser(Parser* parser)
 {
-    advance_parser(parser);
+    step_parser(parser);
     while (!parser_is_at_end(parser)) {
-        Token tok = previous_token(parser);
-        if (tok.type == SEMICOLON) return;
-
-        tok = peek_token(parser);
-
-        switch (tok.type) {
-            case CLASS:
-            case FUN:
-            case VAR:
-            case FOR:
-            case IF:
-            case WHILE:
-            case PRINT:
-            case RET:
-                return;
-            default:
-                break;
-        }
+        if (previous_type(parser) == SEMICOLON) return;
+
+        if (token_in_set(STATEMENT_START, peek_type(parser))) return;
 
-        advance_parser(parser);
+        step_parser(parser);
     }
 }
 
@@ -334,287 +196,244 @@ consume(Parser* parser, enum TOKEN_TYPE type, const char* message)
     parser_error(ret, message);
     advance_parser(parser);
     return (Token){ .type = INVALID_TOKEN_INT,
-                    .line = ret.line,
-                    .col = ret.col,
+                    .offset = ret.offset,
                     .lexeme = ret.lexeme,
                     .lexeme_len = ret.lexeme_len };
 }
 
-Expr*
-primary_rule(Parser* parser)
-{
-    Expr* expr = NULL;
-    struct Literal_e* literal = NULL;
-    Token token = { 0 };
-
-    if (match_token(parser, 1, FALSE)) {
-        token = previous_token(parser);
-
-        literal = MEM_LOG_ALLOC(struct Literal_e);
-        *literal = init_literal_expr(token, NULL);
-
-        expr = MEM_LOG_ALLOC(Expr);
-        *expr = init_expression(LITERAL, literal, NULL, &evaluate);
-        return expr;
-    }
-
-    if (match_token(parser, 1, TRUE)) {
-        token = previous_token(parser);
-
-        literal = MEM_LOG_ALLOC(struct Literal_e);
-        *literal = init_literal_expr(token, NULL);
-
-        expr = MEM_LOG_ALLOC(Expr);
-        *expr = init_expression(LITERAL, literal, NULL, &evaluate);
-        return expr;
-    }
-
-    if (match_token(parser, 1, NIL)) {
-        token = previous_token(parser);
-
-        literal = MEM_LOG_ALLOC(struct Literal_e);
-        *literal = init_literal_expr(token, NULL);
-
-        expr = MEM_LOG_ALLOC(Expr);
-        *expr = init_expression(LITERAL, literal, NULL, &evaluate);
-        return expr;
-    }
-
-    if (match_token(parser, 1, STRING)) {
-        token = previous_token(parser);
-
-        literal = MEM_LOG_ALLOC(struct Literal_e);
-        *literal = init_literal_expr(token, NULL);
-
-        expr = MEM_LOG_ALLOC(Expr);
-        *expr = init_expression(LITERAL, literal, NULL, &evaluate);
-        return expr;
-    }
-
-    if (match_token(parser, 1, NUMBER)) {
-        token = previous_token(parser);
-
-        literal = MEM_LOG_ALLOC(struct Literal_e);
-        *literal = init_literal_expr(token, NULL);
-
-        expr = MEM_LOG_ALLOC(Expr);
-        *expr = init_expression(LITERAL, literal, NULL, &evaluate);
-        return expr;
-    }
-
-    if (match_token(parser, 1, IDENTIFIER)) {
-        token = previous_token(parser);
-
-        literal = MEM_LOG_ALLOC(struct Variable_e);
-        *literal = init_literal_expr(token, NULL);
-
-        expr = MEM_LOG_ALLOC(Expr);
-        *expr = init_expression(LITERAL, literal, NULL, &evaluate);
-        return expr;
+/* push a new expression to the pool of the parser */
+static Expr_idx
+new_expr(Parser* parser,
+         enum EXPR_TYPES type,
+         Token token,
+         Expr_idx left,
+         Expr_idx right)
+{
+    return push_expr(parser->exprs, init_expr_node(type, token, left, right));
+}
+
+/* the type of an expression the parser has pushed */
+static inline enum EXPR_TYPES
+expr_type(Parser* parser, Expr_idx idx)
+{
+    return expr_node(parser->exprs, idx)->type;
+}
+
+/* binding powers of the operators, from loosest to tightest */
+enum PRECEDENCE {
+    PREC_NONE,
+    PREC_ASSIGNMENT, /* = */
+    PREC_EQUALITY,   /* == != */
+    PREC_COMPARISON, /* < > <= >= */
+    PREC_TERM,       /* + - */
+    PREC_FACTOR,     /* * / % */
+    PREC_UNARY,      /* ! - */
+    PREC_PRIMARY
+};
+
+/* parses an expression starting at the token just consumed */
+typedef Expr_idx (*Prefix_rule)(Parser* parser);
+
+/* parses the rest of an expression whose left operand is already parsed,
+ * the operator is the token just consumed */
+typedef Expr_idx (*Infix_rule)(Parser* parser, Expr_idx left);
+
+typedef struct {
+    Prefix_rule prefix;
+    Infix_rule infix;
+    /* binding power of the token as an infix operator */
+    enum PRECEDENCE precedence;
+} Parse_rule;
+
+static Expr_idx
+literal_rule(Parser* parser);
+static Expr_idx
+grouping_rule(Parser* parser);
+static Expr_idx
+unary_rule(Parser* parser);
+static Expr_idx
+binary_rule(Parser* parser, Expr_idx left);
+static Expr_idx
+assignment_rule(Parser* parser, Expr_idx left);
+
+/* the parse rules keyed by token type, a token missing
+ * here can neither start nor continue an expression */
+static const Parse_rule parse_rules[INVALID_TOKEN_INT + 1] = {
+    [LEFT_PAREN] = { grouping_rule, NULL, PREC_NONE },
+    [MINUS] = { unary_rule, binary_rule, PREC_TERM },
+    [PLUS] = { NULL, binary_rule, PREC_TERM },
+    [SLASH] = { NULL, binary_rule, PREC_FACTOR },
+    [STAR] = { NULL, binary_rule, PREC_FACTOR },
+    [MOD] = { NULL, binary_rule, PREC_FACTOR },
+    [BANG] = { unary_rule, NULL, PREC_NONE },
+    [BANG_EQUAL] = { NULL, binary_rule, PREC_EQUALITY },
+    [EQUAL] = { NULL, assignment_rule, PREC_ASSIGNMENT },
+    [EQUAL_EQUAL] = { NULL, binary_rule, PREC_EQUALITY },
+    [GREATER] = { NULL, binary_rule, PREC_COMPARISON },
+    [GREATER_EQUAL] = { NULL, binary_rule, PREC_COMPARISON },
+    [LESS] = { NULL, binary_rule, PREC_COMPARISON },
+    [LESS_EQUAL] = { NULL, binary_rule, PREC_COMPARISON },
+    [IDENTIFIER] = { literal_rule, NULL, PREC_NONE },
+    [STRING] = { literal_rule, NULL, PREC_NONE },
+    [NUMBER] = { literal_rule, NULL, PREC_NONE },
+    [FALSE] = { literal_rule, NULL, PREC_NONE },
+    [NIL] = { literal_rule, NULL, PREC_NONE },
+    [TRUE] = { literal_rule, NULL, PREC_NONE },
+};
+
+/* parse an expression whose operators bind at least as tight as precedence
+ * Params:
+ * @parser : the parser
+ * @precedence : the loosest binding power to accept
+ * Ret:
+ * @Expr_idx : the expression, an invalid one if it cannot start here
+ */
+static Expr_idx
+parse_precedence(Parser* parser, enum PRECEDENCE precedence)
+{
+    Prefix_rule prefix = parse_rules[peek_type(parser)].prefix;
+    Expr_idx left;
+
+    if (prefix != NULL) {
+        step_parser(parser);
+        left = prefix(parser);
+    } else {
+        /* if nothing matches then it is just bad, the
+         * token is left for an operator to complain about */
+        left = new_expr(parser,
+                        INVALID_EXPR_INT,
+                        (Token){ .type = INVALID_TOKEN_INT },
+                        NO_EXPR,
+                        NO_EXPR);
     }
 
-    if (match_token(parser, 1, LEFT_PAREN)) {
-        expr = expression_rule(parser);
-
-        consume(parser, RIGHT_PAREN, "Expected a ')' after expression.");
-
-        struct Grouping_e* grp = MEM_LOG_ALLOC(struct Grouping_e);
-        *grp = init_group_expr(expr, NULL);
-
-        Expr* gexpr = MEM_LOG_ALLOC(Expr);
-        *gexpr = init_expression(GROUPING, grp, NULL, &evaluate);
-
-        return gexpr;
+    while (precedence <= parse_rules[peek_type(parser)].precedence) {
+        step_parser(parser);
+        left = parse_rules[previous_type(parser)].infix(parser, left);
     }
 
-    /* if nothing matches then it is just bad */
-    expr = MEM_LOG_ALLOC(Expr);
-    *expr = init_expression(INVALID_EXPR_INT, NULL, NULL, &evaluate);
-    return expr;
+    return left;
 }
 
-Expr*
-unary_rule(Parser* parser)
+static Expr_idx
+literal_rule(Parser* parser)
 {
-    if (match_token(parser, 2, BANG, MINUS)) {
-        Token Operator = previous_token(parser);
-        Expr* right = unary_rule(parser);
-        if (right->type == INVALID_EXPR_INT) {
-            parser_error(Operator, "Invalid operand on RHS");
-            return right;
-        }
-
-        struct Unary_e* unary = MEM_LOG_ALLOC(struct Unary_e);
-        *unary = init_unary_expr(Operator, right, NULL);
-
-        Expr* unary_expr = MEM_LOG_ALLOC(Expr);
-        *unary_expr = init_expression(UNARY, unary, NULL, &evaluate);
-        return unary_expr;
-    }
-
-    return primary_rule(parser);
+    return new_expr(parser, LITERAL, previous_token(parser), NO_EXPR, NO_EXPR);
 }
 
-Expr*
-factor_rule(Parser* parser)
+static Expr_idx
+grouping_rule(Parser* parser)
 {
-    Expr* binary_expr = unary_rule(parser);
-    size_t cnt = 0;
-
-    while (match_token(parser, 3, SLASH, MOD, STAR)) {
-        Token Operator = previous_token(parser);
-        Expr* right = unary_rule(parser);
-        if (binary_expr->type == INVALID_EXPR_INT) {
-            parser_error(Operator, "Expected an operand on LHS");
-        }
-        if (right->type == INVALID_EXPR_INT) {
-            parser_error(Operator, "Expected an operand on RHS");
-        }
-
-        struct Binary_e* binary = MEM_LOG_ALLOC(struct Binary_e);
-        *binary = init_binary_expr(binary_expr, Operator, right, NULL);
-        if (cnt) binary->nests = true;
+    Token paren = previous_token(parser);
+    Expr_idx expr = expression_rule(parser);
 
-        binary_expr = MEM_LOG_ALLOC(Expr);
-        *binary_expr = init_expression(BINARY, binary, NULL, &evaluate);
-        cnt++;
+    if (expr_type(parser, expr) == INVALID_EXPR_INT) {
+        parser_error(paren, "Expected an expression inside the parentheses");
+        parser->had_error = true;
     }
 
-    return binary_expr;
+    Token rparen = consume(parser, RIGHT_PAREN, "Expected a ')' after expression.");
+    if (rparen.type == INVALID_TOKEN_INT) parser->had_error = true;
+
+    return new_expr(parser, GROUPING, paren, expr, NO_EXPR);
 }
 
-Expr*
-term_rule(Parser* parser)
+static Expr_idx
+unary_rule(Parser* parser)
 {
-    Expr* binary_expr = factor_rule(parser);
-    size_t cnt = 0;
-
-    while (match_token(parser, 2, MINUS, PLUS)) {
-        Token Operator = previous_token(parser);
-        Expr* right = factor_rule(parser);
-        if (binary_expr->type == INVALID_EXPR_INT) {
-            parser_error(Operator, "Expected an operand on LHS");
-        }
-        if (right->type == INVALID_EXPR_INT) {
-            parser_error(Operator, "Expected an operand on RHS");
-        }
-
-        struct Binary_e* binary = MEM_LOG_ALLOC(struct Binary_e);
-        *binary = init_binary_expr(binary_expr, Operator, right, NULL);
-        if (cnt) binary->nests = true;
-
-        binary_expr = MEM_LOG_ALLOC(Expr);
-        *binary_expr = init_expression(BINARY, binary, NULL, &evaluate);
-        cnt++;
+    Token Operator = previous_token(parser);
+    Expr_idx right = parse_precedence(parser, PREC_UNARY);
+    if (expr_type(parser, right) == INVALID_EXPR_INT) {
+        parser_error(Operator, "Invalid operand on RHS");
+        parser->had_error = true;
+        return right;
     }
 
-    return binary_expr;
+    return new_expr(parser, UNARY, Operator, NO_EXPR, right);
 }
 
-Expr*
-comparison_rule(Parser* parser)
+/* binary operators are left associative, the right operand only
+ * takes operators binding tighter than this one */
+static Expr_idx
+binary_rule(Parser* parser, Expr_idx left)
 {
-    Expr* binary_expr = term_rule(parser);
-    size_t cnt = 0;
-
-    while (match_token(parser, 4, GREATER, GREATER_EQUAL, LESS, LESS_EQUAL)) {
-        Token Operator = previous_token(parser);
-        Expr* right = term_rule(parser);
-        if (binary_expr->type == INVALID_EXPR_INT) {
-            parser_error(Operator, "Expected an operand on LHS");
-        }
-        if (right->type == INVALID_EXPR_INT) {
-            parser_error(Operator, "Expected an operand on RHS");
-        }
-
-        struct Binary_e* binary = MEM_LOG_ALLOC(struct Binary_e);
-        *binary = init_binary_expr(binary_expr, Operator, right, NULL);
-        if (cnt) binary->nests = true;
+    Token Operator = previous_token(parser);
+    enum PRECEDENCE precedence = parse_rules[Operator.type].precedence;
+    Expr_idx right = parse_precedence(parser, precedence + 1);
 
-        binary_expr = MEM_LOG_ALLOC(Expr);
-        *binary_expr = init_expression(BINARY, binary, NULL, &evaluate);
-        cnt++;
+    /* the program must not run with an invalid operand */
+    if (expr_type(parser, left) == INVALID_EXPR_INT) {
+        parser_error(Operator, "Expected an operand on LHS");
+        parser->had_error = true;
     }
+    if (expr_type(parser, right) == INVALID_EXPR_INT) {
+        parser_error(Operator, "Expected an operand on RHS");
+        parser->had_error = true;
+    }
+
+    /* a left operand of the same precedence is the
+     * previous operator of a chain like 'a - b - c' */
+    const Expr_node* lhs = expr_node(parser->exprs, left);
+    Expr_node node = init_expr_node(BINARY, Operator, left, right);
+    node.nests =
+      lhs->type == BINARY && parse_rules[lhs->token].precedence == precedence;
 
-    return binary_expr;
+    return push_expr(parser->exprs, node);
 }
 
-Expr*
-equality_rule(Parser* parser)
+/* assignment is right associative */
+static Expr_idx
+assignment_rule(Parser* parser, Expr_idx left)
 {
-    Expr* binary_expr = comparison_rule(parser);
-    size_t cnt = 0;
-
-    while (match_token(parser, 2, BANG_EQUAL, EQUAL_EQUAL)) {
-        Token Operator = previous_token(parser);
-        Expr* right = comparison_rule(parser);
-        if (binary_expr->type == INVALID_EXPR_INT) {
-            parser_error(Operator, "Expected an operand on LHS");
-        }
-        if (right->type == INVALID_EXPR_INT) {
-            parser_error(Operator, "Expected an operand on RHS");
-        }
+    Token equals = previous_token(parser);
+    Expr_idx rvalue = parse_precedence(parser, PREC_ASSIGNMENT);
 
-        struct Binary_e* binary = MEM_LOG_ALLOC(struct Binary_e);
-        *binary = init_binary_expr(binary_expr, Operator, right, NULL);
-        if (cnt) binary->nests = true;
+    if (expr_type(parser, rvalue) == INVALID_EXPR_INT) {
+        parser_error(equals, "Expected a value to assign");
+        parser->had_error = true;
+    }
 
-        binary_expr = MEM_LOG_ALLOC(Expr);
-        *binary_expr = init_expression(BINARY, binary, NULL, &evaluate);
-        cnt++;
+    /* identifiers are parsed as literals, the one on the left
+     * of '=' becomes the variable that is assigned */
+    const Expr_node* target = expr_node(parser->exprs, left);
+    if (target->type == LITERAL && target->token == IDENTIFIER) {
+        Token name = expr_token(parser->exprs, left);
+        return new_expr(parser, VARIABLE, name, NO_EXPR, rvalue);
     }
 
-    return binary_expr;
+    REPORT_PARSER_ERROR_INTERNAL(equals, "Invalid lvalue for assignment.");
+    parser->had_error = true;
+    return left;
 }
 
-Expr*
-assignment_rule(Parser* parser)
+Expr_idx
+expression_rule(Parser* parser)
 {
-    Expr* expr = equality_rule(parser);
-
-    if (match_token(parser, 1, EQUAL)) {
-        Token equals = previous_token(parser);
-        Expr* rvalue = assignment_rule(parser);
-
-        if (expr->type == VARIABLE) {
-            Token name = expr->variable->name;
-            deallocate_expr(expr);
-
-            struct Variable_e* assign = MEM_LOG_ALLOC(struct Variable_e);
-            *assign = init_variable_expr(name, rvalue, NULL);
-
-            Expr* assigned = MEM_LOG_ALLOC(Expr);
-            *assigned = init_expression(VARIABLE, assign, NULL, &evaluate);
-
-            return assigned;
-        }
-
-        REPORT_PARSER_ERROR_INTERNAL(equals, "Invalid lvalue for assignment.");
-        deallocate_expr(rvalue);
-    }
-
-    return expr;
+    return parse_precedence(parser, PREC_ASSIGNMENT);
 }
 
-Expr*
-expression_rule(Parser* parser)
+static Statement*
+allocate_statements(Parser* parser, size_t count)
 {
-    return assignment_rule(parser);
+    return arena_alloc(parser->arena, count * sizeof(Statement));
 }
 
-void*
-allocate_statements(size_t count)
+/* double the capacity of a statement array allocated from the arena */
+static Statement*
+grow_statements(Parser* parser, Statement* statements, size_t count)
 {
-    return malloc(count * sizeof(Statement));
+    return arena_grow(parser->arena,
+                      statements,
+                      count * sizeof(Statement),
+                      count * 2 * sizeof(Statement));
 }
 
 static Statement
-print_statement(Parser* parser, Env_manager* env_mgr)
+print_statement(Parser* parser)
 {
-    Expr* value = expression_rule(parser);
+    Expr_idx value = expression_rule(parser);
     Token semicolon = consume(parser, SEMICOLON, "Expected a ';' after expression.");
-    if (value->type == INVALID_EXPR_INT) {
-        deallocate_expr(value);
+    if (expr_type(parser, value) == INVALID_EXPR_INT) {
         synchronize_parser(parser);
         parser_error(semicolon, "Invalid expression to print");
         parser->had_error = true;
@@ -623,19 +442,18 @@ print_statement(Parser* parser, Env_manager* env_mgr)
         parser->had_error = true;
     }
 
-    return (Statement){ .type = PRINT_STMT,
-                        .accept = &eval_print_stmt,
-                        .prtStmt =
-                          (Print_statement){ .expression = value, .tok = semicolon },
-                        .env_idx = env_mgr->env_idx };
+    return (Statement){
+        .type = PRINT_STMT,
+        .prtStmt = (Print_statement){ .expression = value, .tok = semicolon },
+    };
 }
 
 static Statement
-expression_statement(Parser* parser, Env_manager* env_mgr)
+expression_statement(Parser* parser)
 {
-    Expr* value = expression_rule(parser);
+    Expr_idx value = expression_rule(parser);
     Token semicolon = consume(parser, SEMICOLON, "Expected a ';' after expression.");
-    if (value->type == INVALID_EXPR_INT) {
+    if (expr_type(parser, value) == INVALID_EXPR_INT) {
         synchronize_parser(parser);
         parser->had_error = true;
     }
@@ -644,22 +462,21 @@ expression_statement(Parser* parser, Env_manager* env_mgr)
         parser->had_error = true;
     }
 
-    return (Statement){ .type = EXPR_STMT,
-                        .accept = &eval_expr_stmt,
-                        .exStmt =
-                          (Expr_statement){ .expression = value, .tok = semicolon },
-                        .env_idx = env_mgr->env_idx };
+    return (Statement){
+        .type = EXPR_STMT,
+        .exStmt = (Expr_statement){ .expression = value, .tok = semicolon },
+    };
 }
 
 static Statement
-var_declaration(Parser* parser, Env_manager* env_mgr)
+var_declaration(Parser* parser)
 {
     Token name = consume(parser, IDENTIFIER, "Expected identifier.");
-    Expr* init = NULL;
+    Expr_idx init = NO_EXPR;
 
-    if (match_token(parser, 1, EQUAL)) {
+    if (match_token(parser, EQUAL)) {
         init = expression_rule(parser);
-        if (init->type == INVALID_EXPR_INT) {
+        if (expr_type(parser, init) == INVALID_EXPR_INT) {
             synchronize_parser(parser);
             parser->had_error = true;
         }
@@ -671,89 +488,45 @@ var_declaration(Parser* parser, Env_manager* env_mgr)
     }
 
     return (Statement){ .type = VAR_DECL_STMT,
-                        .vardecl = (Var_decl){ .tok = name, .expression = init },
-                        .accept = &eval_var_stmt,
-                        .env_idx = env_mgr->env_idx };
+                        .vardecl = (Var_decl){ .tok = name, .expression = init } };
 }
 
 static Statement
-declaration(Parser* parser, Env_manager* env_mgr);
+declaration(Parser* parser);
 static Statement
-statement(Parser* parser, Env_manager* env_mgr);
+statement(Parser* parser);
 
 static Statement
-block(Parser* parser, Env_manager* env_mgr)
+block(Parser* parser)
 {
-    Statement* statements = allocate_statements(STMT_CNT * sizeof(Statement));
+    Statement* statements = allocate_statements(parser, STMT_CNT);
     size_t idx = 0;
     size_t have_stmts = STMT_CNT;
 
-    env_mgr->env_idx++;
-    env_mgr->total_envs++;
-    env_mgr->envs =
-      realloc(env_mgr->envs, sizeof(Environment*) * (env_mgr->env_idx + 1));
-    if (env_mgr->envs == NULL) {
-        error(0,
-              0,
-              "While creating Block Environment, reallocated environment pointer is "
-              "NULL");
-        exit(EX_OSERR);
-    }
-
-    sh_new_arena(env_mgr->envs[env_mgr->env_idx]);
-
     while (!check_token(parser, RIGHT_BRACE) && !parser_is_at_end(parser)) {
         if (idx == have_stmts) {
-            statements = realloc(statements, have_stmts * 2 * sizeof(Statement));
-            if (statements == NULL) {
-                shfree(env_mgr->envs[env_mgr->env_idx]);
-                REPORT_PARSER_ERROR_INTERNAL((Token){ .type = INVALID_TOKEN_INT },
-                                             "Out of memory");
-                exit(EX_OSERR);
-            }
+            statements = grow_statements(parser, statements, have_stmts);
             have_stmts *= 2;
         }
-        statements[idx] = declaration(parser, env_mgr);
-        statements[idx++].env_idx = env_mgr->env_idx;
+        statements[idx++] = declaration(parser);
     }
 
     statements[0].count = idx;
 
-    if (consume(parser, RIGHT_BRACE, "Expected a '}' after block.").type ==
-        INVALID_TOKEN_INT) {
-        shfree(env_mgr->envs[env_mgr->env_idx]);
-        env_mgr->env_idx--;
-
-        env_mgr->envs =
-          realloc(env_mgr->envs, sizeof(Environment*) * (env_mgr->env_idx + 1));
-        if (env_mgr->envs == NULL) {
-            error(0,
-                  0,
-                  "While shrinking Block Environment, reallocated environment "
-                  "pointer is NULL");
-            exit(EX_OSERR);
-        }
-
-        for (size_t i = 0; i < statements[0].count; i++) {
-            if (statements[i].type != BLOCK_STMT)
-                deallocate_expr(statements[i].exStmt.expression);
-        }
-        free(statements);
-    }
+    Token rbrace = consume(parser, RIGHT_BRACE, "Expected a '}' after block.");
+    if (rbrace.type == INVALID_TOKEN_INT) parser->had_error = true;
 
     return (Statement){ .block = (Block){ .statements = statements },
-                        .type = BLOCK_STMT,
-                        .accept = eval_block,
-                        .env_idx = env_mgr->env_idx };
+                        .type = BLOCK_STMT };
 }
 
 static Statement
-if_statement(Parser* parser, Env_manager* env_mgr)
+if_statement(Parser* parser)
 {
     Token lparen = consume(parser, LEFT_PAREN, "Expected a '(' after 'if'.");
     if (lparen.type == INVALID_TOKEN_INT) parser->had_error = true;
-    Expr* condition = expression_rule(parser);
-    if (condition->type == INVALID_EXPR_INT) {
+    Expr_idx condition = expression_rule(parser);
+    if (expr_type(parser, condition) == INVALID_EXPR_INT) {
         synchronize_parser(parser);
         parser->had_error = true;
     }
@@ -763,77 +536,58 @@ if_statement(Parser* parser, Env_manager* env_mgr)
         parser->had_error = true;
     }
 
-    Statement then_branch = statement(parser, env_mgr);
+    Statement then_branch = statement(parser);
     Statement else_branch = { .type = BAD_STMT };
-    if (match_token(parser, 1, ELSE)) else_branch = statement(parser, env_mgr);
+    if (match_token(parser, ELSE)) else_branch = statement(parser);
 
-    If_stmt ifStmt = init_ifStmt(condition);
+    If_stmt ifStmt = init_ifStmt(parser->arena, condition);
     ifStmt.branches[THEN_BRNCH] = then_branch;
     ifStmt.branches[ELSE_BRNCH] = else_branch;
 
     return (Statement){
         .ifStmt = ifStmt,
         .type = IF_STMT,
-        .accept = eval_if_stmt,
-        .env_idx = env_mgr->env_idx,
     };
 }
 
 static Statement
-statement(Parser* parser, Env_manager* env_mgr)
+statement(Parser* parser)
 {
-    if (match_token(parser, 1, IF)) return if_statement(parser, env_mgr);
-    if (match_token(parser, 1, PRINT)) return print_statement(parser, env_mgr);
-    if (match_token(parser, 1, LEFT_BRACE)) return block(parser, env_mgr);
+    if (match_token(parser, IF)) return if_statement(parser);
+    if (match_token(parser, PRINT)) return print_statement(parser);
+    if (match_token(parser, LEFT_BRACE)) return block(parser);
 
-    return expression_statement(parser, env_mgr);
+    return expression_statement(parser);
 }
 
 static Statement
-declaration(Parser* parser, Env_manager* env_mgr)
+declaration(Parser* parser)
 {
-    if (match_token(parser, 1, VAR)) return var_declaration(parser, env_mgr);
+    if (match_token(parser, VAR)) return var_declaration(parser);
 
-    return statement(parser, env_mgr);
+    return statement(parser);
 }
 
 Statement*
 parse(Program* program)
 {
-    program->parser->statements = allocate_statements(STMT_CNT * sizeof(Statement));
+    program->parser->statements = allocate_statements(program->parser, STMT_CNT);
     size_t cnt = 0;
     size_t have_stmts = STMT_CNT;
 
     while (!parser_is_at_end(program->parser)) {
         if (cnt == have_stmts) {
-            program->parser->statements = realloc(
-              program->parser->statements, have_stmts * 2 * sizeof(Statement));
-            if (program->parser->statements == NULL) {
-                REPORT_PARSER_ERROR_INTERNAL((Token){ .type = INVALID_TOKEN_INT },
-                                             "Out of memory");
-                exit(EX_OSERR);
-            }
+            program->parser->statements = grow_statements(
+              program->parser, program->parser->statements, have_stmts);
             have_stmts *= 2;
         }
 
         program->parser->statements[program->parser->current_statement_idx++] =
-          declaration(program->parser, program->env_mgr);
+          declaration(program->parser);
 
+        /* the statements are released with the arena */
         if (program->parser->had_error) {
             synchronize_parser(program->parser);
-            for (size_t i = 0; i < program->parser->current_statement_idx; i++) {
-                if (program->parser->statements[i].type == IF_STMT) {
-                    deallocate_expr(program->parser->statements[i].ifStmt.condition);
-                    free(program->parser->statements[i].ifStmt.branches);
-                    continue;
-                }
-                if (program->parser->statements[i].type == BLOCK_STMT) {
-                    free(program->parser->statements[i].block.statements);
-                    continue;
-                }
-                deallocate_expr(program->parser->statements[i].exStmt.expression);
-            }
-            free(program->parser->statements);
             return NULL;
         }
         cnt++;
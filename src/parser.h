@@ -25,99 +25,50 @@
 #include <stddef.h>
 #include <stdlib.h>
 
+#include "arena.h"
+#include "expr_pool.h"
+#include "scanner.h"
 #include "token.h"
 
-typedef struct Expr_t Expr;
 typedef struct Program_t Program;
 typedef struct Env_t Environment;
+/* a stack of environments, 'env_idx' is the innermost scope and
+ * 'total_envs' the number of environments allocated, the global
+ * scope is the first */
 typedef struct {
-    Environment** envs;
+    Environment* envs;
     size_t env_idx;
     size_t total_envs;
 } Env_manager;
 
-typedef struct Object_t {
-    union {
-        double number;
-        bool boolean;
-    };
-    char* string;
-    size_t string_len;
-    enum TOKEN_TYPE type;
-} Object;
-
-/* atomic structures that make up the expression structure */
-struct Binary_e {
-    Token Operator;
-    Expr* left;
-    Expr* right;
-    // visitor pattern. Make the expression visit any function.
-    void (*accept)(Env_manager* env_mgr, struct Binary_e*);
-    bool nests;
-};
-
-struct Grouping_e {
-    Expr* expression;
-    void (*accept)(Env_manager* env_mgr, struct Grouping_e*);
-};
-
-struct Unary_e {
-    Token Operator;
-    Expr* right;
-    void (*accept)(Env_manager* env_mgr, struct Unary_e*);
-};
-
-struct Literal_e {
-    Token value;
-    void (*accept)(Env_manager* env_mgr, struct Literal_e*);
-};
-
-struct Variable_e {
-    Token name;
-    Expr* value;
-    void (*accept)(Env_manager* env_mgr, struct Variable_e*);
-};
-
-/* the molecule - expression */
-struct Expr_t {
-    union {
-        struct Binary_e* binary;
-        struct Grouping_e* group;
-        struct Unary_e* unary;
-        struct Literal_e* literal;
-        struct Variable_e* variable;
-    };
-    void (*accept)(Expr*);
-    Object (*evaluate)(Env_manager* env_mgr, Expr*, bool*);
-    enum EXPR_TYPES {
-        LITERAL,
-        UNARY,
-        BINARY,
-        GROUPING,
-        VARIABLE,
-        INVALID_EXPR_INT
-    } type;
-};
-
 typedef struct {
     Token tok;
-    Expr* expression;
+    Expr_idx expression;
 } Expr_statement;
 
 typedef Expr_statement Print_statement;
-typedef Expr_statement Var_decl;
 typedef struct Statement_t Statement;
 
+typedef struct {
+    Token tok;
+    Expr_idx expression;
+    /* the slot of the variable in its scope, set by resolve() */
+    uint32_t slot;
+} Var_decl;
+
 typedef struct {
     Statement* statements;
+    /* the number of variables declared in the block, set by resolve() */
+    uint32_t slot_cnt;
 } Block;
 
 typedef struct {
-    Expr* condition;
+    Expr_idx condition;
     Statement* branches;
-    enum { THEN_BRNCH, ELSE_BRNCH } ran;
 } If_stmt;
 
+enum { THEN_BRNCH, ELSE_BRNCH };
+
 struct Statement_t {
     union {
         Expr_statement exStmt;
@@ -126,9 +77,7 @@ struct Statement_t {
         If_stmt ifStmt;
         Block block;
     };
-    void (*accept)(Env_manager* env_mgr, Statement, bool*);
     size_t count;
-    size_t env_idx;
     enum STMT_TYPE {
         EXPR_STMT,
         PRINT_STMT,
@@ -139,27 +88,32 @@ struct Statement_t {
     } type;
 };
 
+/* number of tokens the parser keeps around, must be a power of two */
+enum { PARSER_LOOKAHEAD = 4 };
+
 typedef struct {
-    Token* tokens;
+    /* tokens are pulled from the scanner on demand into a ring buffer,
+     * 'current_token_idx' and 'pulled_token_cnt' count all tokens pulled */
+    Scanner* scanner;
+    /* the statements are allocated from the arena and
+     * the expressions are pushed to the pool */
+    Arena* arena;
+    Expr_pool* exprs;
+    Token lookahead[PARSER_LOOKAHEAD];
     Statement* statements;
     size_t current_token_idx;
+    size_t pulled_token_cnt;
     size_t current_statement_idx;
     bool had_error;
 } Parser;
 
 /******* Functions ********/
 
-/* initialise the parser */
+/* initialise the parser to pull tokens from the scanner, the statements
+ * are allocated from the arena and the expressions pushed to the pool,
+ * which must not hold the AST of another source */
 Parser
-init_parser(Token* tokens);
-
-/* expression allocator */
-void*
-allocate_expr(void);
-
-/* expression de-allocator */
-void
-deallocate_expr(Expr* expr);
+init_parser(Scanner* scanner, Arena* arena, Expr_pool* exprs);
 
 Statement*
 parse(Program* program);
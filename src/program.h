@@ -21,17 +21,35 @@
 #define CLOX_BASIC_PROGRAM_STRUCTURES_H
 
 #include "parser.h"
+#include "arena.h"
+#include "expr_pool.h"
+#include "intern.h"
 #include "scanner.h"
+#include "utility.h"
 #include <stddef.h>
 
+typedef struct Slot_entry Slot_entry;
+
 typedef struct Program_t {
     Scanner* scanner;
     Parser* parser;
     Statement* statements;
     Env_manager* env_mgr;
-    Token** toks_list;
-    size_t* tok_cnt;
-    size_t toks_list_cnt;
+    /* token lexemes are views into these buffers and are referred
+     * to by the environments, so they live as long as the program */
+    Source_file* source_list;
+    size_t source_cnt;
+    /* identifiers and string literals of every source */
+    Intern_table strings;
+    /* the global variables of every source run so far and their
+     * slots, a stb_ds hash map keyed by the interned name */
+    Slot_entry* globals;
+    /* the AST of the source being run, statements
+     * come from the arena and expressions from the pool */
+    Arena ast;
+    Expr_pool exprs;
+    /* run on the bytecode virtual machine instead of walking the AST */
+    bool bytecode;
     bool had_runtime_error;
 } Program;
 
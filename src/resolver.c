@@ -0,0 +1,225 @@
+// clox-basic - C Language Implementation of jlox from Crafting Interpreters.
+//
+// Copyright (C) 2022 Amritpal Singh
+//
+// This file is part of clox-basic.
+//
+// clox-basic is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3
+// of the License, or (at your option) any later version.
+//
+// clox-basic is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied
+// warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// clox-basic. If not, see <https://www.gnu.org/licenses/>.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "environment.h"
+#include "expr_pool.h"
+#include "parser.h"
+#include "program.h"
+#include "resolver.h"
+#include "token.h"
+#include "utility.h"
+
+/* the scopes the walk is in, the global scope of the program is outermost */
+typedef struct {
+    Program* program;
+    Expr_pool* exprs;
+    /* stb_ds array of the block scopes, innermost last */
+    Slot_entry** scopes;
+    /* the number of globals before this program */
+    size_t old_global_cnt;
+    bool had_error;
+} Resolver;
+
+static void
+resolver_error(Resolver* resolver, const Expr_node* node, const char* message)
+{
+    const char* fmt = "at '%.*s' %s";
+    const char* lexeme = resolver->exprs->source + node->offset;
+    size_t len = snprintf(NULL, 0, fmt, (int)node->len, lexeme, message);
+    char* buffer = malloc(len + 1);
+    snprintf(buffer, len + 1, fmt, (int)node->len, lexeme, message);
+
+    error(node->offset, buffer);
+    free(buffer);
+    resolver->had_error = true;
+}
+
+/* find the scope a name is declared in, from the innermost out.
+ * Blocks can only be entered from where they are written, so at
+ * runtime the scope is the same number of environments out.
+ * Params:
+ * @resolver : the resolver
+ * @node : an identifier or an assignment, gets the depth and slot
+ */
+static void
+resolve_name(Resolver* resolver, Expr_node* node)
+{
+    size_t scope_cnt = arrlenu(resolver->scopes);
+
+    for (size_t i = scope_cnt; i-- > 0;) {
+        ptrdiff_t at = hmgeti(resolver->scopes[i], node->interned);
+        if (at >= 0) {
+            node->depth = scope_cnt - 1 - i;
+            node->slot = resolver->scopes[i][at].value;
+            return;
+        }
+    }
+
+    ptrdiff_t at = hmgeti(resolver->program->globals, node->interned);
+    if (at >= 0) {
+        node->depth = scope_cnt;
+        node->slot = resolver->program->globals[at].value;
+        return;
+    }
+
+    /* globals are declared in the order they run, one
+     * used before its declaration is undefined too */
+    resolver_error(resolver, node, "Undefined variable.");
+}
+
+static void
+resolve_expr(Resolver* resolver, Expr_idx expr)
+{
+    if (expr == NO_EXPR) return;
+
+    Expr_node* node = &resolver->exprs->nodes[expr];
+    switch (node->type) {
+        case LITERAL:
+            if (node->token == IDENTIFIER) resolve_name(resolver, node);
+            break;
+        case UNARY:
+            resolve_expr(resolver, node->right);
+            break;
+        case BINARY:
+            resolve_expr(resolver, node->left);
+            resolve_expr(resolver, node->right);
+            break;
+        case GROUPING:
+            resolve_expr(resolver, node->left);
+            break;
+        case VARIABLE:
+            resolve_expr(resolver, node->right);
+            resolve_name(resolver, node);
+            break;
+        default:
+            break;
+    }
+}
+
+/* declare a variable in the innermost scope, declaring a name again
+ * in the same scope reuses its slot
+ * Params:
+ * @resolver : the resolver
+ * @decl : the declaration, gets the slot
+ */
+static void
+declare(Resolver* resolver, Var_decl* decl)
+{
+    Slot_entry** scope = arrlenu(resolver->scopes) == 0
+                           ? &resolver->program->globals
+                           : &arrlast(resolver->scopes);
+
+    ptrdiff_t at = hmgeti(*scope, decl->tok.interned);
+    if (at >= 0) {
+        decl->slot = (*scope)[at].value;
+        return;
+    }
+
+    decl->slot = hmlenu(*scope);
+    hmput(*scope, decl->tok.interned, decl->slot);
+}
+
+static void
+resolve_stmt(Resolver* resolver, Statement* stmt);
+
+static void
+resolve_block(Resolver* resolver, Block* block)
+{
+    arrput(resolver->scopes, NULL);
+    for (size_t i = 0; i < block->statements[0].count; i++)
+        resolve_stmt(resolver, &block->statements[i]);
+
+    Slot_entry* scope = arrpop(resolver->scopes);
+    block->slot_cnt = hmlenu(scope);
+    hmfree(scope);
+}
+
+static void
+resolve_stmt(Resolver* resolver, Statement* stmt)
+{
+    switch (stmt->type) {
+        case EXPR_STMT:
+            resolve_expr(resolver, stmt->exStmt.expression);
+            break;
+        case PRINT_STMT:
+            resolve_expr(resolver, stmt->prtStmt.expression);
+            break;
+        case VAR_DECL_STMT:
+            /* the initialiser sees the variables of the enclosing scopes */
+            resolve_expr(resolver, stmt->vardecl.expression);
+            declare(resolver, &stmt->vardecl);
+            break;
+        case IF_STMT:
+            resolve_expr(resolver, stmt->ifStmt.condition);
+            resolve_stmt(resolver, &stmt->ifStmt.branches[THEN_BRNCH]);
+            resolve_stmt(resolver, &stmt->ifStmt.branches[ELSE_BRNCH]);
+            break;
+        case BLOCK_STMT:
+            resolve_block(resolver, &stmt->block);
+            break;
+        case BAD_STMT:
+            break;
+    }
+}
+
+/* the program is not run after an error, so the globals it declared
+ * are forgotten for the sources that follow
+ * Params:
+ * @resolver : the resolver
+ */
+static void
+forget_new_globals(Resolver* resolver)
+{
+    Slot_entry** globals = &resolver->program->globals;
+
+    /* deleting moves the last entry into the place of the deleted one */
+    for (size_t i = hmlenu(*globals); i-- > 0;) {
+        if ((*globals)[i].value >= resolver->old_global_cnt)
+            (void)hmdel(*globals, (*globals)[i].key);
+    }
+}
+
+/* resolve the variables of a parsed program, run after fold_constants()
+ * as the depth of a variable takes the place of the left operand.
+ * Params:
+ * @program : the program, parsed without errors
+ * Ret:
+ * @bool : false when a variable is undefined, the program must not run
+ */
+bool
+resolve(Program* program)
+{
+    Resolver resolver = { .program = program,
+                          .exprs = &program->exprs,
+                          .old_global_cnt = hmlenu(program->globals) };
+
+    for (size_t i = 0; i < program->statements[0].count; i++)
+        resolve_stmt(&resolver, &program->statements[i]);
+
+    arrfree(resolver.scopes);
+    if (resolver.had_error) forget_new_globals(&resolver);
+
+    return !resolver.had_error;
+}
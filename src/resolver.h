@@ -0,0 +1,41 @@
+#pragma once
+// clox-basic - C Language Implementation of jlox from Crafting Interpreters.
+//
+// Copyright (C) 2022 Amritpal Singh
+//
+// This file is part of clox-basic.
+//
+// clox-basic is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3
+// of the License, or (at your option) any later version.
+//
+// clox-basic is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied
+// warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// clox-basic. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef CLOX_BASIC_RESOLVER_H
+#define CLOX_BASIC_RESOLVER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "intern.h"
+#include "program.h"
+
+/* a declared name and the slot of its variable, stb_ds hash map entry */
+typedef struct Slot_entry {
+    const Interned_string* key;
+    uint32_t value;
+} Slot_entry;
+
+/* give every variable of the parsed program the scope and slot it is
+ * declared in, returns false when a variable is used undeclared */
+bool
+resolve(Program* program);
+
+#endif
@@ -0,0 +1,144 @@
+// clox-basic - C Language Implementation of jlox from Crafting Interpreters.
+//
+// Copyright (C) 2022 Amritpal Singh
+//
+// This file is part of clox-basic.
+//
+// clox-basic is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3
+// of the License, or (at your option) any later version.
+//
+// clox-basic is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied
+// warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// clox-basic. If not, see <https://www.gnu.org/licenses/>.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "scan_simd.h"
+
+/* the vector type and operations used below, one bit per byte in the masks */
+#if defined(__AVX2__)
+enum { VEC_WIDTH = 32 };
+typedef __m256i vec;
+#define vec_load(P) _mm256_loadu_si256((const __m256i*)(P))
+#define vec_splat(C) _mm256_set1_epi8(C)
+#define vec_eq(A, B) _mm256_cmpeq_epi8((A), (B))
+#define vec_or(A, B) _mm256_or_si256((A), (B))
+#define vec_and(A, B) _mm256_and_si256((A), (B))
+#define vec_mask(A) ((uint32_t)_mm256_movemask_epi8(A))
+#define ALL_BYTES 0xffffffffu
+#elif defined(__SSE2__)
+enum { VEC_WIDTH = 16 };
+typedef __m128i vec;
+#define vec_load(P) _mm_loadu_si128((const __m128i*)(P))
+#define vec_splat(C) _mm_set1_epi8(C)
+#define vec_eq(A, B) _mm_cmpeq_epi8((A), (B))
+#define vec_or(A, B) _mm_or_si128((A), (B))
+#define vec_and(A, B) _mm_and_si128((A), (B))
+#define vec_mask(A) ((uint32_t)_mm_movemask_epi8(A))
+#define ALL_BYTES 0xffffu
+#endif
+
+static inline int
+is_space(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+/* skip whitespace
+ * Params:
+ * @source : the lox source
+ * @pos : offset to start at
+ * @end : offset to stop at
+ * Ret:
+ * @size_t : offset of the first non-whitespace byte or 'end'
+ */
+size_t
+skip_whitespace(const char* source, size_t pos, size_t end)
+{
+#ifdef VEC_WIDTH
+    const vec space = vec_splat(' ');
+    const vec tab = vec_splat('\t');
+    const vec cr = vec_splat('\r');
+    const vec lf = vec_splat('\n');
+
+    while (pos + VEC_WIDTH <= end) {
+        vec chunk = vec_load(source + pos);
+        vec white = vec_or(vec_or(vec_eq(chunk, space), vec_eq(chunk, tab)),
+                           vec_or(vec_eq(chunk, cr), vec_eq(chunk, lf)));
+        uint32_t mask = vec_mask(white) ^ ALL_BYTES;
+        if (mask != 0) return pos + __builtin_ctz(mask);
+        pos += VEC_WIDTH;
+    }
+#endif
+    while (pos < end && is_space(source[pos]))
+        pos++;
+    return pos;
+}
+
+/* find a byte
+ * Params:
+ * @source : the lox source
+ * @pos : offset to start at
+ * @end : offset to stop at
+ * @c : the byte to look for
+ * Ret:
+ * @size_t : offset of the first 'c' or 'end'
+ */
+size_t
+find_byte(const char* source, size_t pos, size_t end, char c)
+{
+#ifdef VEC_WIDTH
+    const vec needle = vec_splat(c);
+
+    while (pos + VEC_WIDTH <= end) {
+        uint32_t mask = vec_mask(vec_eq(vec_load(source + pos), needle));
+        if (mask != 0) return pos + __builtin_ctz(mask);
+        pos += VEC_WIDTH;
+    }
+#endif
+    while (pos < end && source[pos] != c)
+        pos++;
+    return pos;
+}
+
+/* find the end of a block comment
+ * Params:
+ * @source : the lox source
+ * @pos : offset to start at
+ * @end : offset to stop at
+ * Ret:
+ * @size_t : offset of the '*' of the first "*" "/" pair or 'end'
+ */
+size_t
+find_comment_end(const char* source, size_t pos, size_t end)
+{
+#ifdef VEC_WIDTH
+    const vec star = vec_splat('*');
+    const vec slash = vec_splat('/');
+
+    /* compare the '*'s against the bytes following them for the '/'s */
+    while (pos + VEC_WIDTH + 1 <= end) {
+        vec stars = vec_eq(vec_load(source + pos), star);
+        vec slashes = vec_eq(vec_load(source + pos + 1), slash);
+        uint32_t mask = vec_mask(vec_and(stars, slashes));
+        if (mask != 0) return pos + __builtin_ctz(mask);
+        pos += VEC_WIDTH;
+    }
+#endif
+    while (pos + 1 < end && (source[pos] != '*' || source[pos + 1] != '/'))
+        pos++;
+    return pos + 1 < end ? pos : end;
+}
@@ -0,0 +1,43 @@
+#pragma once
+// clox-basic - C Language Implementation of jlox from Crafting Interpreters.
+//
+// Copyright (C) 2022 Amritpal Singh
+//
+// This file is part of clox-basic.
+//
+// clox-basic is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3
+// of the License, or (at your option) any later version.
+//
+// clox-basic is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied
+// warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// clox-basic. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef CLOX_BASIC_SCAN_SIMD_H
+#define CLOX_BASIC_SCAN_SIMD_H
+
+#include <stddef.h>
+
+/* vectorised helpers for the scanner to skip over runs of bytes. They use AVX2
+ * or SSE2 when the compiler targets them and a scalar loop otherwise. All of
+ * them look at source[pos] up to source[end - 1] and never read past 'end'. */
+
+/* offset of the first byte from pos that is not ' ', '\t', '\r' or '\n',
+ * 'end' if there is none */
+size_t
+skip_whitespace(const char* source, size_t pos, size_t end);
+
+/* offset of the first byte 'c' from pos, 'end' if there is none */
+size_t
+find_byte(const char* source, size_t pos, size_t end, char c);
+
+/* offset of the first "*" "/" pair from pos, 'end' if there is none */
+size_t
+find_comment_end(const char* source, size_t pos, size_t end);
+
+#endif
@@ -22,7 +22,10 @@
 #include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
+#include "dfa_scanner.h"
+#include "scan_simd.h"
 #include "scanner.h"
 #include "token.h"
 #include "utility.h"
@@ -38,17 +41,30 @@ Scanner
 init_scanner(const char* source, const size_t source_length)
 {
     Scanner scanner = { .source = source,
-                        .token_max = TOKEN_CNT,
-                        .tokens = allocate_tokens(TOKEN_CNT),
+                        .lexer = DEFAULT_LEXER,
+                        .tokens = NULL,
+                        .token_max = 0,
                         .tokens_count = 0,
                         .source_length = source_length,
                         .start = 0,
-                        .current = 0,
-                        .line = 1 };
+                        .current = 0 };
 
     return scanner;
 }
 
+/* report an error at the start of the current token, quiet scanners
+ * only count it
+ * Params:
+ * @scanner : the scanner structure
+ * @message : the error message
+ */
+void
+scanner_error(Scanner* scanner, const char* message)
+{
+    scanner->error_cnt++;
+    if (!scanner->quiet) error(scanner->start, message);
+}
+
 /* returns the absolute value of a double
  * Params:
  * @d : value of double to be absolute'd
@@ -62,47 +78,39 @@ abs_d(double d)
     return d;
 }
 
-static size_t
-find_col(Scanner* scanner)
-{
-    return scanner->start - scanner->line_start_column + 1;
-}
-
-/* add a new token to scanner's token array
+/* produce a new token from the scanner, the lexeme of the token
+ * is a view into the lox source and is not allocated
  * @scanner : the scanner structure
  * @type : the type of token to be added
  * @start : the location where the token in lox's source starts
  * @end : the location where the token in lox's source ends
  */
-static void
+void
 add_token(Scanner* scanner, enum TOKEN_TYPE type, size_t start, size_t end)
 {
-    if (type == ENDOF) {
-        /* token count is not incremented here because it is the last token */
-        scanner->tokens[scanner->tokens_count] =
-          init_tok(type, "", 0, 0, scanner->line, find_col(scanner) + 1);
+    scanner->have_token = true;
 
+    if (type == ENDOF) {
+        scanner->token = init_tok(type, "", scanner->source_length, 0, 0);
         return;
     }
 
-    /* get the token as a string from the lox source */
-    char* text = get_substr(scanner->source, start, end, NULL);
+    const char* text = scanner->source + start;
 
     /* perform conversion if we have a NUMBER token */
     if (type == NUMBER) {
-        scanner->tokens[scanner->tokens_count++] =
-          init_tok(type,
-                   text,
-                   end - start,
-                   abs_d(strtod(text, NULL)),
-                   scanner->line,
-                   find_col(scanner));
-
+        scanner->token = init_tok(type,
+                                  text,
+                                  start,
+                                  end - start,
+                                  abs_d(parse_number(text, end - start)));
         return;
     }
 
-    scanner->tokens[scanner->tokens_count++] =
-      init_tok(type, text, end - start, 0, scanner->line, find_col(scanner));
+    scanner->token = init_tok(type, text, start, end - start, 0);
+
+    if (scanner->strings != NULL && (type == IDENTIFIER || type == STRING))
+        scanner->token.interned = intern_string(scanner->strings, text, end - start);
 }
 
 /* returns if the scanner has reached the end of lox source
@@ -181,16 +189,11 @@ character_peek_next(const Scanner* scanner)
 static void
 string(Scanner* scanner)
 {
-    while (character_peek(scanner) != '"' && (!scanner_is_at_end(scanner))) {
-        if (character_peek(scanner) == '\n') scanner->line++;
-        advance_scanner(scanner);
-    }
+    scanner->current =
+      find_byte(scanner->source, scanner->current, scanner->source_length, '"');
 
     if (scanner_is_at_end(scanner)) {
-        error(scanner->line,
-              scanner->tokens[scanner->tokens_count - 1].col +
-                scanner->tokens[scanner->tokens_count - 1].lexeme_len + 2,
-              "Unterminated String");
+        scanner_error(scanner, "Unterminated String");
         return;
     }
 
@@ -231,12 +234,8 @@ identifier(Scanner* scanner)
     while (isalnum(character_peek(scanner)))
         advance_scanner(scanner);
 
-    const char* text =
-      get_substr(scanner->source, scanner->start, scanner->current, NULL);
-
-    enum TOKEN_TYPE type = get_keyword(text);
-
-    free((void*)text);
+    enum TOKEN_TYPE type = get_keyword(scanner->source + scanner->start,
+                                       scanner->current - scanner->start);
 
     add_token(scanner, type, scanner->start, scanner->current);
 }
@@ -304,36 +303,28 @@ scan_unit_token(Scanner* scanner)
         case '/':
             if (match_character(scanner, '/')) {
                 // A comment in lox goes until the end of line.
-                while (character_peek(scanner) != '\n' &&
-                       (!scanner_is_at_end(scanner)))
-                    advance_scanner(scanner);
+                scanner->current = find_byte(
+                  scanner->source, scanner->current, scanner->source_length, '\n');
             } else if (match_character(scanner, '*')) {
                 /* this is a block comment in lox */
                 /* and look, it can go
                    across lines */
-                while ((character_peek(scanner) != '*' ||
-                        character_peek_next(scanner) != '/') &&
-                       (!scanner_is_at_end(scanner))) {
-
-                    /* handle the newlines inside of the block comments */
-                    if (character_peek(scanner) == '\n') {
-                        scanner->line++;
-                        scanner->line_start_column = scanner->current;
-                    }
-                    advance_scanner(scanner);
-                }
-                advance_scanner(scanner);
-                advance_scanner(scanner);
+                size_t end = find_comment_end(
+                  scanner->source, scanner->current, scanner->source_length);
+
+                /* skip the closing '*' '/' unless it is unterminated */
+                scanner->current =
+                  end == scanner->source_length ? end : end + 2;
             } else
                 add_token(scanner, SLASH, scanner->start, scanner->current);
             break;
+        /* lines are only resolved from offsets when reporting errors */
         case ' ':
         case '\r':
         case '\t':
-            break;
         case '\n':
-            scanner->line++;
-            scanner->line_start_column = scanner->current;
+            scanner->current = skip_whitespace(
+              scanner->source, scanner->current, scanner->source_length);
             break;
         case '"':
             string(scanner);
@@ -343,35 +334,88 @@ scan_unit_token(Scanner* scanner)
             else if (isalpha(c))
                 identifier(scanner);
             else
-                error(scanner->line,
-                      scanner->tokens[scanner->tokens_count - 1].col +
-                        scanner->tokens[scanner->tokens_count - 1].lexeme_len + 2,
-                      "Unexpected character.");
+                scanner_error(scanner, "Unexpected character.");
             break;
     }
 }
 
-/* scans all tokens in the lox source code
+/* scans the next token in the lox source code, whitespace and comments
+ * are skipped until a token is found or the end of source is reached
  * Params :
  * @scanner : the scanner structure
- * Ret (Optional to be saved) :
- * @Token* : A pointer to all the tokens read
+ * Ret :
+ * @Token : the next token, ENDOF once the whole source has been scanned
  */
-Token*
-scan_tokens(Scanner* scanner)
+Token
+scanner_next_token(Scanner* scanner)
 {
+    if (scanner->scanned_ahead) {
+        /* keep handing out ENDOF once the buffer is exhausted */
+        size_t idx = scanner->next_token;
+        if (idx < scanner->tokens_count) scanner->next_token++;
+        return scanner->tokens[idx];
+    }
+
+    if (scanner->lexer == DFA_LEXER) return dfa_next_token(scanner);
+
+    scanner->have_token = false;
+
     while (!scanner_is_at_end(scanner)) {
-        if (scanner->tokens_count == scanner->token_max)
-            extend_tokens_by(&scanner->tokens, scanner->tokens_count, TOKEN_CNT);
         scanner->start = scanner->current;
         scan_unit_token(scanner);
-    }
 
-    /* make sure we have space for one more token */
-    if (scanner->tokens_count == scanner->token_max)
-        extend_tokens_by(&scanner->tokens, scanner->tokens_count, 2);
+        if (scanner->have_token) {
+            scanner->tokens_count++;
+            return scanner->token;
+        }
+    }
 
     add_token(scanner, ENDOF, 0, 0);
+    return scanner->token;
+}
+
+/* doubles the capacity of the token buffer
+ * Params :
+ * @scanner : the scanner structure
+ */
+static void
+grow_tokens(Scanner* scanner)
+{
+    extend_tokens_by(&scanner->tokens, scanner->token_max, scanner->token_max);
+    scanner->token_max *= 2;
+
+    scanner->stats.reallocs++;
+    scanner->stats.peak_capacity = scanner->token_max;
+}
+
+/* scans all tokens in the lox source code into the scanner's token buffer
+ * Params :
+ * @scanner : the scanner structure
+ * Ret (Optional to be saved) :
+ * @Token* : A pointer to all the tokens read
+ */
+Token*
+scan_tokens(Scanner* scanner)
+{
+    /* one more for the ENDOF token */
+    size_t capacity = scanner->source_length / BYTES_PER_TOKEN + 1;
+    if (capacity < TOKEN_CNT) capacity = TOKEN_CNT;
+
+    scanner->tokens = allocate_tokens(capacity);
+    scanner->token_max = capacity;
+    scanner->stats = (Scanner_stats){ .initial_capacity = capacity,
+                                      .peak_capacity = capacity };
+
+    for (;;) {
+        /* the ENDOF token is not counted in tokens_count */
+        size_t idx = scanner->tokens_count;
+        Token token = scanner_next_token(scanner);
+
+        if (idx == scanner->token_max) grow_tokens(scanner);
+        scanner->tokens[idx] = token;
+
+        if (token.type == ENDOF) break;
+    }
 
     return scanner->tokens;
 }
\ No newline at end of file
@@ -21,28 +21,77 @@
 #ifndef CLOX_BASIC_SCANNER_H
 #define CLOX_BASIC_SCANNER_H
 
+#include "intern.h"
 #include "token.h"
+#include <stdbool.h>
 #include <stddef.h>
 
 #define TOKEN_CNT 120L
+/* average bytes of lox source per token, used to estimate the initial
+ * capacity of the token buffer from the length of the source */
+#define BYTES_PER_TOKEN 4L
+
+/* statistics of the token buffer, to check the capacity estimate */
+typedef struct Scanner_stats {
+    size_t initial_capacity;
+    size_t peak_capacity;
+    size_t reallocs;
+} Scanner_stats;
+
+/* the lexer cores that can produce tokens for the scanner */
+enum LEXER {
+    SWITCH_LEXER, /* hand written, dispatches on each character */
+    DFA_LEXER     /* table driven, see dfa_scanner.c */
+};
+
+#ifdef CLOX_DFA_LEXER
+#define DEFAULT_LEXER DFA_LEXER
+#else
+#define DEFAULT_LEXER SWITCH_LEXER
+#endif
 
 typedef struct Scanner {
     const char* source;
+    enum LEXER lexer;
+    /* the last token produced by the scanner */
+    Token token;
+    bool have_token;
+    /* token buffer, only allocated by scan_tokens() */
     Token* tokens;
+    /* set when the token buffer holds the whole source, scanner_next_token()
+     * then hands out tokens[next_token] instead of scanning */
+    bool scanned_ahead;
+    size_t next_token;
+    /* interns identifiers and strings when set */
+    Intern_table* strings;
+    /* only count errors instead of reporting them */
+    bool quiet;
+    size_t error_cnt;
+    Scanner_stats stats;
     size_t token_max;
     size_t tokens_count;
     size_t source_length;
     size_t start;
     size_t current;
-    size_t line;
-    size_t line_start_column;
 } Scanner;
 
 /* initialise the scanner */
 Scanner
 init_scanner(const char* source, const size_t source_length);
 
-/* start scanning the tokens */
+/* scan and return the next token */
+Token
+scanner_next_token(Scanner* scanner);
+
+/* produce a token with the given type and lexeme for the lexer cores */
+void
+add_token(Scanner* scanner, enum TOKEN_TYPE type, size_t start, size_t end);
+
+/* report an error at the start of the current token */
+void
+scanner_error(Scanner* scanner, const char* message);
+
+/* scan all the tokens into the scanner's token buffer */
 Token*
 scan_tokens(Scanner* scanner);
 
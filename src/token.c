@@ -77,24 +77,23 @@ const char* TokenTypeString[] = {
 /* initialise a token by calling this function
  * Params:
  * @type : the type of token scanned
- * @lexeme : the lexeme/word scanned
+ * @lexeme : the lexeme/word scanned, a view into the source buffer
+ * @offset : the offset of the lexeme in the source buffer
+ * @lexeme_len : the length of the lexeme
  * @num : a double precision floating point literal scanned
- * @line : the line where the lexeme was found
  */
 Token
 init_tok(enum TOKEN_TYPE type,
-         char* lexeme,
+         const char* lexeme,
+         size_t offset,
          size_t lexeme_len,
-         double num,
-         size_t line,
-         size_t col)
+         double num)
 {
     return (Token){ .type = type,
                     .lexeme = lexeme,
+                    .offset = offset,
                     .lexeme_len = lexeme_len,
-                    .num_literal = num,
-                    .line = line,
-                    .col = col };
+                    .num_literal = num };
 }
 
 /* returns a human readabble null-terminated formatted string from Token
@@ -106,24 +105,23 @@ init_tok(enum TOKEN_TYPE type,
 const char*
 token_to_str(const Token* token)
 {
-    char* fmt = "%15s '%s' line: %ld col: %ld ";
+    char* fmt = "%15s '%.*s' offset: %ld ";
     size_t fmt_len = snprintf(NULL,
                               0,
                               fmt,
                               TokenTypeString[token->type],
+                              (int)token->lexeme_len,
                               token->lexeme,
-                              token->line,
-                              token->col);
+                              token->offset);
 
     if (token->type == NUMBER) {
-        fmt = "%15s %lf line: %ld col: %ld ";
+        fmt = "%15s %lf offset: %ld ";
         fmt_len = snprintf(NULL,
                            0,
                            fmt,
                            TokenTypeString[token->type],
                            token->num_literal,
-                           token->line,
-                           token->col);
+                           token->offset);
     }
     char* buf = malloc(fmt_len + 1);
 
@@ -133,8 +131,7 @@ token_to_str(const Token* token)
                  fmt,
                  TokenTypeString[token->type],
                  token->num_literal,
-                 token->line,
-                 token->col);
+                 token->offset);
         return buf;
     }
 
@@ -142,9 +139,9 @@ token_to_str(const Token* token)
              fmt_len,
              fmt,
              TokenTypeString[token->type],
+             (int)token->lexeme_len,
              token->lexeme,
-             token->line,
-             token->col);
+             token->offset);
     return buf;
 }
 
@@ -174,19 +171,11 @@ extend_tokens_by(Token** tokens, unsigned long prev_count, unsigned long count)
     *tokens = realloc(*tokens, (prev_count + count) * sizeof(Token));
 }
 
-/* deallocate the tokens - free the lexemes and then the tokens block
+/* deallocate the tokens block, the lexemes belong to the source buffer
  * Params:
- * @tokens : main block of tokens
- * @tokencnt : the number of tokens present in 'tokens'*/
+ * @tokens : main block of tokens */
 void
-deallocate_tokens(Token* tokens, size_t tokencnt)
+deallocate_tokens(Token* tokens)
 {
-    size_t counter = 0;
-
-    /* last EndOfFile Token does not need free()-ing*/
-    while (counter < tokencnt) {
-        free(tokens[counter].lexeme);
-        counter++;
-    }
     free(tokens);
 }
\ No newline at end of file
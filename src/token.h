@@ -21,7 +21,12 @@
 #ifndef CLOX_BASIC_TOKEN_H
 #define CLOX_BASIC_TOKEN_H
 
+#include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
+
+#include "intern.h"
+
 enum TOKEN_TYPE {
     /* Single Character Tokens */
     LEFT_PAREN,
@@ -78,23 +83,66 @@ enum TOKEN_TYPE {
     INVALID_TOKEN_INT
 };
 
+/* a set of token types, one bit per type */
+typedef uint64_t Token_set;
+
+_Static_assert(INVALID_TOKEN_INT < 64, "every token type needs a bit of a set");
+
+/* the set holding only 'type' */
+#define TOKEN_BIT(type) ((Token_set)1 << (type))
+
+/* a constant set of up to eight token types, e.g. TOKEN_SET(MINUS, PLUS) */
+#define TOKEN_SET(...)                                                              \
+    TOKEN_SET_PICK(__VA_ARGS__,                                                     \
+                   TOKEN_SET_8,                                                     \
+                   TOKEN_SET_7,                                                     \
+                   TOKEN_SET_6,                                                     \
+                   TOKEN_SET_5,                                                     \
+                   TOKEN_SET_4,                                                     \
+                   TOKEN_SET_3,                                                     \
+                   TOKEN_SET_2,                                                     \
+                   TOKEN_SET_1,                                                     \
+                   0)                                                               \
+    (__VA_ARGS__)
+
+#define TOKEN_SET_PICK(_1, _2, _3, _4, _5, _6, _7, _8, N, ...) N
+#define TOKEN_SET_1(a) TOKEN_BIT(a)
+#define TOKEN_SET_2(a, ...) (TOKEN_BIT(a) | TOKEN_SET_1(__VA_ARGS__))
+#define TOKEN_SET_3(a, ...) (TOKEN_BIT(a) | TOKEN_SET_2(__VA_ARGS__))
+#define TOKEN_SET_4(a, ...) (TOKEN_BIT(a) | TOKEN_SET_3(__VA_ARGS__))
+#define TOKEN_SET_5(a, ...) (TOKEN_BIT(a) | TOKEN_SET_4(__VA_ARGS__))
+#define TOKEN_SET_6(a, ...) (TOKEN_BIT(a) | TOKEN_SET_5(__VA_ARGS__))
+#define TOKEN_SET_7(a, ...) (TOKEN_BIT(a) | TOKEN_SET_6(__VA_ARGS__))
+#define TOKEN_SET_8(a, ...) (TOKEN_BIT(a) | TOKEN_SET_7(__VA_ARGS__))
+
+/* whether 'type' is in the set */
+static inline bool
+token_in_set(Token_set set, enum TOKEN_TYPE type)
+{
+    return (set & TOKEN_BIT(type)) != 0;
+}
+
+/* a token does not own its lexeme, 'lexeme' is a view of 'lexeme_len' bytes
+ * starting at byte 'offset' of the scanned source and is not null-terminated.
+ * Lines and columns are only resolved from the offset when reporting errors.
+ * Identifiers and strings also refer to their interned copy when the scanner
+ * has an intern table */
 typedef struct Token {
-    char* lexeme;
+    const char* lexeme;
+    const Interned_string* interned;
     double num_literal;
+    size_t offset;
     size_t lexeme_len;
-    size_t line;
-    size_t col;
     enum TOKEN_TYPE type;
 } Token;
 
 /* initialise token with value */
 Token
 init_tok(enum TOKEN_TYPE type,
-         char* lexeme,
+         const char* lexeme,
+         size_t offset,
          size_t lexeme_len,
-         double num,
-         size_t line,
-         size_t col);
+         double num);
 
 /* convert token to string representation */
 const char*
@@ -113,6 +161,6 @@ extend_tokens_by(Token** tokens,
 
 /* free() the allocated memory for the tokens */
 void
-deallocate_tokens(Token* tokens, size_t tokencnt);
+deallocate_tokens(Token* tokens);
 
 #endif
\ No newline at end of file
@@ -17,122 +17,130 @@
 // You should have received a copy of the GNU General Public License along with
 // clox-basic. If not, see <https://www.gnu.org/licenses/>.
 
+#define _POSIX_C_SOURCE 200809L
+
 #include <errno.h>
+#include <fcntl.h>
+#include <float.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <sysexits.h>
+#include <unistd.h>
 
 #include "token.h"
 #include "utility.h"
 
-/* some external globals for use */
-extern const char* TokenTypeString[40];
+/* initial buffer size when a file has to be read instead of mapped */
+enum { READ_CHUNK = 4096 };
 
-/* read a file into a buffer and return it.
+/* read everything from a file descriptor into a heap-allocated buffer, used
+ * for pipes, terminals and anything else that cannot be mapped
  * Params:
- * @filename : name of file to be read
- * @filesize : a pointer to a size_t - set to the size of file read
+ * @fd : the file descriptor to read from
+ * @filesize : a pointer to a size_t - set to the number of bytes read
  * Ret:
- * @char* : pointer to null terminated char sequence - the file read
+ * @char* : pointer to null terminated char sequence - the data read
  */
-char*
-readfile(const char* filename, size_t* filesize)
+static char*
+read_fd(int fd, size_t* filesize)
 {
-    /* open a file stream to filename*/
-    FILE* file = fopen(filename, "r");
-    if (file == NULL) {
-        fprintf(
-          stderr, "Error: Could not open file with fopen(): %s\n", strerror(errno));
+    size_t capacity = READ_CHUNK;
+    size_t size = 0;
+    char* filedata = malloc(capacity + 1);
+    if (filedata == NULL) {
+        fprintf(stderr, "Error: malloc(%zu) returned NULL\n", capacity + 1);
         exit(EX_OSERR);
     }
 
-    /* goto the end of the file stream */
-    if (fseek(file, 0L, SEEK_END) != 0) {
-        fprintf(stderr, "Error: fseek() could not seek to end of file\n");
-        exit(EX_UNAVAILABLE);
-    }
+    for (;;) {
+        if (size == capacity) {
+            capacity *= 2;
+            filedata = realloc(filedata, capacity + 1);
+            if (filedata == NULL) {
+                fprintf(stderr, "Error: realloc(%zu) returned NULL\n", capacity + 1);
+                exit(EX_OSERR);
+            }
+        }
 
-    /* obtain the how big the file is */
-    long int sz = ftell(file);
-    if (sz == -1L) {
-        fprintf(stderr,
-                "Error: ftell() could not obtain position in file: %s\n",
-                strerror(errno));
-        exit(EX_UNAVAILABLE);
+        ssize_t n = read(fd, filedata + size, capacity - size);
+        if (n == 0) break;
+        if (n == -1) {
+            if (errno == EINTR) continue;
+            fprintf(
+              stderr, "Error: reading data with read(): %s\n", strerror(errno));
+            exit(EX_IOERR);
+        }
+        size += n;
     }
 
-    *filesize = sz;
+    filedata[size] = '\0';
+    *filesize = size;
+    return filedata;
+}
 
-    /* go back to the beginning */
-    if (fseek(file, 0L, SEEK_SET) != 0) {
-        fprintf(stderr, "Error: fseek() could not seek back to beginning of file\n");
-        exit(EX_UNAVAILABLE);
+/* load a file into memory and return it. Regular files are mapped read-only
+ * so the scanner works directly on the page cache, everything else (pipes,
+ * /dev/stdin) is read into a heap-allocated buffer.
+ * Params:
+ * @filename : name of file to be read
+ * Ret:
+ * @Source_file : the file data, not null-terminated when mapped
+ */
+Source_file
+readfile(const char* filename)
+{
+    int fd = open(filename, O_RDONLY);
+    if (fd == -1) {
+        fprintf(
+          stderr, "Error: Could not open file with open(): %s\n", strerror(errno));
+        exit(EX_OSERR);
     }
 
-    /* allocate a buffer to hold the user specified file in memory */
-    char* filedata = malloc(sz + 1);
-    if (filedata == NULL) {
-        fprintf(stderr, "Error: malloc(%ld) returned NULL\n", sz + 1);
-        exit(EX_OSERR);
+    struct stat st;
+    if (fstat(fd, &st) == -1) {
+        fprintf(stderr,
+                "Error: fstat() could not obtain file status: %s\n",
+                strerror(errno));
+        exit(EX_UNAVAILABLE);
     }
 
-    /* read the file into the buffer */
-    if (fread(filedata, sizeof(char), sz, file) != (unsigned long)sz) {
-        if (feof(file)) {
-            fprintf(stderr,
-                    "Error: reading data with fread(): Early end-of-file "
-                    "indicator in file "
-                    "stream\n");
-            exit(EX_IOERR);
-        }
-        if (ferror(file)) {
-            fprintf(stderr,
-                    "Error: reading data with fread(): error indicator in file "
-                    "stream\n");
-            exit(EX_IOERR);
+    Source_file file = { 0 };
+
+    /* empty files can not be mapped */
+    if (S_ISREG(st.st_mode) && st.st_size > 0) {
+        void* data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) {
+            posix_madvise(data, st.st_size, POSIX_MADV_SEQUENTIAL);
+            file = (Source_file){ .data = data, .size = st.st_size, .mapped = true };
         }
-        fprintf(stderr, "Error: reading data with fread(): Unknown error\n");
-        exit(EX_IOERR);
     }
 
-    if (fclose(file) != 0) {
-        fprintf(stderr,
-                "Error: fclose() could not close file stream: %s\n",
-                strerror(errno));
+    if (!file.mapped) file.data = read_fd(fd, &file.size);
+
+    if (close(fd) != 0) {
+        fprintf(
+          stderr, "Error: close() could not close file: %s\n", strerror(errno));
         exit(EX_OSERR);
     }
 
-    return filedata;
+    return file;
 }
 
-/* gets a heap-allocated substring from the given string
+/* release a file loaded with readfile()
  * Params:
- * @str : the main string from which the substring is to be obtained
- * @start : the offset to the first character of substring in str
- * @end : the offset to the last character of substring in str
- * Ret:
- * @const char* : a pointer to a const null-terminated char array
- * i.e the substring
+ * @file : the file to be released
  */
-char*
-get_substr(const char* str, size_t start, size_t end, size_t* substr_len)
+void
+freefile(Source_file file)
 {
-    /* return null if the size to get is zero */
-    if (end - start == 0) return NULL;
-
-    char* substr = malloc((end - start) + 1);
-    size_t cnt = 0;
-    while (cnt < (end - start)) {
-        substr[cnt] = str[start + cnt];
-        cnt++;
-    }
-    substr[cnt] = '\0';
-    if (substr_len != NULL) *substr_len = end - start;
-
-    return substr;
+    if (file.mapped) munmap((void*)file.data, file.size);
+    else free((void*)file.data);
 }
 
 /* report an error to stderr -- internal use only
@@ -148,77 +156,257 @@ report(size_t line, size_t col, const char* where, const char* message)
       stderr, RED_2 "[At %ld:%ld ] Error %s: %s\n" RESET, line, col, where, message);
 }
 
+/* the source buffer that error offsets refer to, the offsets of the
+ * line starts are only collected once the first error is reported */
+static struct {
+    const char* source;
+    size_t length;
+    size_t* line_starts;
+    size_t line_cnt;
+} error_source;
+
+/* set the source buffer the offsets passed to error() refer to
+ * Params:
+ * @source : the lox source buffer
+ * @length : length of the buffer
+ */
+void
+set_error_source(const char* source, size_t length)
+{
+    free(error_source.line_starts);
+    error_source.source = source;
+    error_source.length = length;
+    error_source.line_starts = NULL;
+    error_source.line_cnt = 0;
+}
+
+/* build the table of offsets where the lines of the error source start */
+static void
+index_lines(void)
+{
+    const char* source = error_source.source;
+    size_t length = error_source.length;
+    size_t capacity = 64;
+
+    error_source.line_starts = malloc(capacity * sizeof(size_t));
+    error_source.line_starts[error_source.line_cnt++] = 0;
+
+    const char* newline = NULL;
+    size_t offset = 0;
+    while (offset < length &&
+           (newline = memchr(source + offset, '\n', length - offset)) != NULL) {
+        if (error_source.line_cnt == capacity) {
+            capacity *= 2;
+            error_source.line_starts =
+              realloc(error_source.line_starts, capacity * sizeof(size_t));
+        }
+        offset = newline - source + 1;
+        error_source.line_starts[error_source.line_cnt++] = offset;
+    }
+}
+
+/* resolve an offset of the error source to a line and a column
+ * Params:
+ * @offset : the offset in the source
+ * @line : set to the line of the offset
+ * @col : set to the column of the offset
+ */
+static void
+resolve_offset(size_t offset, size_t* line, size_t* col)
+{
+    if (error_source.line_starts == NULL) index_lines();
+
+    /* find the last line starting at or before the offset */
+    size_t low = 0;
+    size_t high = error_source.line_cnt;
+    while (high - low > 1) {
+        size_t mid = low + (high - low) / 2;
+        if (error_source.line_starts[mid] <= offset) low = mid;
+        else
+            high = mid;
+    }
+
+    *line = low + 1;
+    *col = offset - error_source.line_starts[low] + 1;
+}
+
 /* print out an error
  * Params:
- * @line : the line where the error occurred
+ * @offset : the offset in the source where the error occurred,
+ *           NO_SOURCE_OFFSET if the error is not related to the source
  * @message : the error message
  */
 void
-error(size_t line, size_t col, const char* message)
+error(size_t offset, const char* message)
 {
+    size_t line = 0;
+    size_t col = 0;
+
+    if (offset != NO_SOURCE_OFFSET && error_source.source != NULL)
+        resolve_offset(offset, &line, &col);
     report(line, col, "", message);
 }
 
-/* non-lexicographic string compare
- * compares two strings upto count characters or
- * until either of two strings has a zero-byte
+/* checks if the rest of an identifier matches the rest of a keyword
  * Params:
- * @s1 : the first string
- * @s2 : the second string
- * @count : number of characters to compare */
-bool
-strncmp_nl(const char* s1, const char* s2, size_t count)
+ * @str : the identifier
+ * @len : length of the identifier
+ * @start : the number of characters already matched by get_keyword()
+ * @rest : the remaining characters of the keyword
+ * @rest_len : the number of remaining characters of the keyword
+ * @type : the token type of the keyword
+ * Ret:
+ * @enum TOKEN_TYPE : 'type' if the whole keyword matched, IDENTIFIER otherwise
+ */
+static enum TOKEN_TYPE
+check_keyword(const char* str,
+              size_t len,
+              size_t start,
+              const char* rest,
+              size_t rest_len,
+              enum TOKEN_TYPE type)
 {
-    if (s1 == NULL || s2 == NULL) return false;
-    if (count == 0) return false;
-
-    while (count--) {
-        if (*s1 == '\0' || *s2 == '\0') return false;
-        if (*s1++ != *s2++) return false;
-    }
-    return true;
+    if (len == start + rest_len && memcmp(str + start, rest, rest_len) == 0)
+        return type;
+    return IDENTIFIER;
 }
 
-/* get the token type of a keyword from a given string if it matches
+/* get the token type of a keyword from a given string if it matches,
+ * the keywords are recognized by a trie unrolled into switch statements
+ * so any identifier is resolved with at most one memcmp()
  * Params:
- * @str: the string which is to be compared and the
- * keyword key is to be obtained
+ * @str: the string which is to be compared, need not be null-terminated
+ * @len: the length of the string
  *Ret:
  * @enum TOKEN_TYPE: a token type is returned for iff a string match
- * is found with a keyword
+ * is found with a keyword, otherwise IDENTIFIER
  */
 enum TOKEN_TYPE
-get_keyword(const char* str)
+get_keyword(const char* str, size_t len)
 {
-    if (strncmp_nl(str, TokenTypeString[AND], strlen(TokenTypeString[AND])))
-        return AND;
-    if (strncmp_nl(str, TokenTypeString[CLASS], strlen(TokenTypeString[CLASS])))
-        return CLASS;
-    if (strncmp_nl(str, TokenTypeString[ELSE], strlen(TokenTypeString[ELSE])))
-        return ELSE;
-    if (strncmp_nl(str, TokenTypeString[FALSE], strlen(TokenTypeString[FALSE])))
-        return FALSE;
-    if (strncmp_nl(str, TokenTypeString[FOR], strlen(TokenTypeString[FOR])))
-        return FOR;
-    if (strncmp_nl(str, TokenTypeString[FUN], strlen(TokenTypeString[FUN])))
-        return FUN;
-    if (strncmp_nl(str, TokenTypeString[IF], strlen(TokenTypeString[IF]))) return IF;
-    if (strncmp_nl(str, TokenTypeString[NIL], strlen(TokenTypeString[NIL])))
-        return NIL;
-    if (strncmp_nl(str, TokenTypeString[OR], strlen(TokenTypeString[OR]))) return OR;
-    if (strncmp_nl(str, TokenTypeString[PRINT], strlen(TokenTypeString[PRINT])))
-        return PRINT;
-    if (strncmp_nl(str, TokenTypeString[RET], strlen(TokenTypeString[RET])))
-        return RET;
-    if (strncmp_nl(str, TokenTypeString[SUPER], strlen(TokenTypeString[SUPER])))
-        return SUPER;
-    if (strncmp_nl(str, TokenTypeString[THIS], strlen(TokenTypeString[THIS])))
-        return THIS;
-    if (strncmp_nl(str, TokenTypeString[TRUE], strlen(TokenTypeString[TRUE])))
-        return TRUE;
-    if (strncmp_nl(str, TokenTypeString[VAR], strlen(TokenTypeString[VAR])))
-        return VAR;
-    if (strncmp_nl(str, TokenTypeString[WHILE], strlen(TokenTypeString[WHILE])))
-        return WHILE;
+    if (len < 2) return IDENTIFIER;
+
+    switch (str[0]) {
+        case 'a':
+            return check_keyword(str, len, 1, "nd", 2, AND);
+        case 'c':
+            return check_keyword(str, len, 1, "lass", 4, CLASS);
+        case 'e':
+            return check_keyword(str, len, 1, "lse", 3, ELSE);
+        case 'f':
+            switch (str[1]) {
+                case 'a':
+                    return check_keyword(str, len, 2, "lse", 3, FALSE);
+                case 'o':
+                    return check_keyword(str, len, 2, "r", 1, FOR);
+                case 'u':
+                    return check_keyword(str, len, 2, "n", 1, FUN);
+            }
+            break;
+        case 'i':
+            return check_keyword(str, len, 1, "f", 1, IF);
+        case 'n':
+            return check_keyword(str, len, 1, "il", 2, NIL);
+        case 'o':
+            return check_keyword(str, len, 1, "r", 1, OR);
+        case 'p':
+            return check_keyword(str, len, 1, "rint", 4, PRINT);
+        case 'r':
+            return check_keyword(str, len, 1, "et", 2, RET);
+        case 's':
+            return check_keyword(str, len, 1, "uper", 4, SUPER);
+        case 't':
+            switch (str[1]) {
+                case 'h':
+                    return check_keyword(str, len, 2, "is", 2, THIS);
+                case 'r':
+                    return check_keyword(str, len, 2, "ue", 2, TRUE);
+            }
+            break;
+        case 'v':
+            return check_keyword(str, len, 1, "ar", 2, VAR);
+        case 'w':
+            return check_keyword(str, len, 1, "hile", 4, WHILE);
+    }
     return IDENTIFIER;
+}
+
+/* powers of ten that are exactly representable as a double */
+static const double exact_powers_of_ten[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+enum {
+    MAX_EXACT_POWER = 22,
+    MAX_MANTISSA_DIGITS = 19,
+    NUMBER_BUF_LEN = 64,
+};
+
+/* the largest integer below which every integer is exactly a double */
+#define MAX_EXACT_MANTISSA (UINT64_C(1) << DBL_MANT_DIG)
+
+/* converts a number with strtod(), the string need not be null-terminated so
+ * it is copied to a stack buffer first
+ * Params:
+ * @str : the number in lox source
+ * @len : length of the number
+ * Ret:
+ * @double : the converted number
+ */
+static double
+parse_number_slow(const char* str, size_t len)
+{
+    char buf[NUMBER_BUF_LEN];
+    char* text = buf;
+
+    /* only really long literals need to go on the heap */
+    if (len >= NUMBER_BUF_LEN) text = malloc(len + 1);
+
+    memcpy(text, str, len);
+    text[len] = '\0';
+
+    double num = strtod(text, NULL);
+
+    if (text != buf) free(text);
+    return num;
+}
+
+/* converts a lox number literal (digits with an optional fraction) to a
+ * double without copying it. When the digits fit in the 53 bit mantissa and
+ * the fraction has at most 22 digits, both the digits and the power of ten
+ * are exact doubles and a single division gives the correctly rounded result
+ * (Clinger's fast path). Anything else falls back to strtod().
+ * Params:
+ * @str : the number in lox source, need not be null-terminated
+ * @len : length of the number
+ * Ret:
+ * @double : the converted number
+ */
+double
+parse_number(const char* str, size_t len)
+{
+    uint64_t mantissa = 0;
+    size_t digits = 0;
+    size_t fraction_digits = 0;
+    bool in_fraction = false;
+
+    for (size_t i = 0; i < len; i++) {
+        if (str[i] == '.') {
+            in_fraction = true;
+            continue;
+        }
+
+        if (in_fraction) fraction_digits++;
+        /* leading zeros are not significant */
+        if (mantissa == 0 && str[i] == '0') continue;
+        if (++digits > MAX_MANTISSA_DIGITS) return parse_number_slow(str, len);
+
+        mantissa = mantissa * 10 + (uint64_t)(str[i] - '0');
+    }
+
+    if (mantissa > MAX_EXACT_MANTISSA || fraction_digits > MAX_EXACT_POWER)
+        return parse_number_slow(str, len);
+
+    return (double)mantissa / exact_powers_of_ten[fraction_digits];
 }
\ No newline at end of file
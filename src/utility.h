@@ -23,6 +23,7 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 
 /* define some popular escape sequences */
 /* visit https://github.com/dylanaraps/pure-bash-bible#text-colors for more info
@@ -46,27 +47,42 @@
 
 #define for_range(I, R) for (size_t(I) = 0; (I) < (R); (I)++)
 
-/* reads a file into a heap-allocated buffer and
- * returns the pointer after reading the file */
-char*
-readfile(const char* filename, size_t* filesize);
+/* a lox script in memory, either mapped from a regular file or
+ * held in a heap-allocated buffer */
+typedef struct Source_file {
+    const char* data;
+    size_t size;
+    bool mapped;
+} Source_file;
 
-/* returns a heap allocated null terminated char array containing contents
- * from str[start] to str[end]*/
-char*
-get_substr(const char* str, size_t start, size_t end, size_t* substr_len);
+/* loads a file into memory, mapping it when it is a regular file
+ * and reading it into a heap-allocated buffer otherwise */
+Source_file
+readfile(const char* filename);
 
-/* report an error */
+/* releases a file loaded with readfile() */
 void
-error(size_t line, size_t col, const char* message);
+freefile(Source_file file);
 
-/* non-lexicographic string compare
- * compares upto 'count' characters or until a zero byte is hit */
-bool
-strncmp_nl(const char* s1, const char* s2, size_t count);
+/* offset for errors that are not related to any source location */
+#define NO_SOURCE_OFFSET SIZE_MAX
 
-/* gets the enum TOKEN_TYPE value of the keyword from the str passed to it
- * if str matches to a keyword */
+/* set the source buffer that the offsets of reported errors refer to */
+void
+set_error_source(const char* source, size_t length);
+
+/* report an error at an offset, the line and column are resolved from
+ * the source buffer set with set_error_source() */
+void
+error(size_t offset, const char* message);
+
+/* gets the enum TOKEN_TYPE value of the keyword from the first 'len'
+ * characters of str if they match a keyword, IDENTIFIER otherwise */
 enum TOKEN_TYPE
-get_keyword(const char* str);
+get_keyword(const char* str, size_t len);
+
+/* converts the first 'len' characters of str, a lox number literal, to a
+ * double */
+double
+parse_number(const char* str, size_t len);
 #endif
\ No newline at end of file
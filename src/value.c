@@ -0,0 +1,212 @@
+// clox-basic - C Language Implementation of jlox from Crafting Interpreters.
+//
+// Copyright (C) 2022 Amritpal Singh
+//
+// This file is part of clox-basic.
+//
+// clox-basic is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3
+// of the License, or (at your option) any later version.
+//
+// clox-basic is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied
+// warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// clox-basic. If not, see <https://www.gnu.org/licenses/>.
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stbds.h>
+#include <sysexits.h>
+
+#include "intern.h"
+#include "token.h"
+#include "utility.h"
+#include "value.h"
+
+/* format a number the way print shows it, integers have no fraction and
+ * other numbers as many digits as it takes to read them back unchanged
+ * Params:
+ * @number : the number
+ * @buffer : where the text goes
+ * Ret:
+ * @size_t : the length of the text
+ */
+size_t
+format_number(double number, char buffer[NUMBER_TEXT_SIZE])
+{
+    int len = 0;
+
+    /* 17 significant digits are always enough */
+    for (int precision = 15; precision <= 17; precision++) {
+        len = snprintf(buffer, NUMBER_TEXT_SIZE, "%.*g", precision, number);
+        if (strtod(buffer, NULL) == number) break;
+    }
+
+    return len;
+}
+
+/* allocate memory for an object, exit if we are out of memory */
+static void*
+object_alloc(size_t size)
+{
+    void* memory = malloc(size);
+    if (memory == NULL) {
+        error(NO_SOURCE_OFFSET, "Out of memory while making a string");
+        exit(EX_OSERR);
+    }
+    return memory;
+}
+
+/* drop a reference to an object, the last one frees it. A freed rope drops
+ * the references of its parts, the ropes freed with it are kept in a list
+ * instead of recursing, as repeated + makes ropes as deep as they are long
+ * Params:
+ * @obj : a runtime string or rope
+ */
+static void
+release_obj(Obj* obj)
+{
+    if (obj->type == OBJ_INTERNED || --obj->refs > 0) return;
+    if (obj->type == OBJ_STRING) {
+        free(obj);
+        return;
+    }
+
+    Obj** dead = NULL;
+    arrput(dead, obj);
+    while (arrlen(dead) > 0) {
+        Obj* next = arrpop(dead);
+
+        if (next->type == OBJ_ROPE) {
+            Obj_rope* rope = (Obj_rope*)next;
+            Obj* parts[] = { rope->left,
+                             rope->right,
+                             rope->flat != NULL ? &rope->flat->obj : NULL };
+
+            for (size_t i = 0; i < sizeof(parts) / sizeof(parts[0]); i++) {
+                if (parts[i] == NULL || parts[i]->type == OBJ_INTERNED) continue;
+                if (--parts[i]->refs == 0) arrput(dead, parts[i]);
+            }
+        }
+        free(next);
+    }
+    arrfree(dead);
+}
+
+/* drop a reference to a value, a runtime string or rope is
+ * freed when its last reference goes
+ * Params:
+ * @value : the value, anything but a runtime object is left alone
+ */
+void
+release_value(Value value)
+{
+    if (is_counted(value)) release_obj(as_obj(value));
+}
+
+/* a runtime string of 'len' characters, they are left to the caller */
+static Obj_string*
+allocate_string(size_t len)
+{
+    Obj_string* string = object_alloc(sizeof(Obj_string) + len + 1);
+    string->obj.type = OBJ_STRING;
+    string->obj.refs = 1;
+    string->len = len;
+    string->chars[len] = '\0';
+    return string;
+}
+
+/* make a runtime string of the characters of two strings, its
+ * hash is computed once, here
+ * Params:
+ * @left : the first characters
+ * @left_len : the number of first characters
+ * @right : the characters that follow
+ * @right_len : the number of characters that follow
+ * Ret:
+ * @Obj_string* : the string with a single reference
+ */
+Obj_string*
+concatenate_chars(const char* left,
+                  size_t left_len,
+                  const char* right,
+                  size_t right_len)
+{
+    Obj_string* string = allocate_string(left_len + right_len);
+    memcpy(string->chars, left, left_len);
+    memcpy(string->chars + left_len, right, right_len);
+    string->hash = hash_string(string->chars, string->len);
+    return string;
+}
+
+/* join two strings or ropes in constant time
+ * Params:
+ * @left : the first part, the rope takes over the reference
+ * @right : the part that follows, the rope takes over the reference
+ * Ret:
+ * @Obj_rope* : the rope with a single reference
+ */
+Obj_rope*
+make_rope(Obj* left, Obj* right)
+{
+    Obj_rope* rope = object_alloc(sizeof(Obj_rope));
+    rope->obj.type = OBJ_ROPE;
+    rope->obj.refs = 1;
+    rope->len = string_length(obj_value(left)) + string_length(obj_value(right));
+    rope->left = left;
+    rope->right = right;
+    rope->flat = NULL;
+    return rope;
+}
+
+/* gather the characters of a rope into a string, left to right with a
+ * stack of the parts still to copy. The parts are released afterwards, so
+ * the characters are only ever copied into one flat string per rope
+ * Params:
+ * @rope : the rope
+ * Ret:
+ * @Obj_string* : the characters of the rope, owned by the rope
+ */
+Obj_string*
+flatten_rope(Obj_rope* rope)
+{
+    if (rope->flat != NULL) return rope->flat;
+
+    Obj_string* flat = allocate_string(rope->len);
+    size_t copied = 0;
+
+    Obj** parts = NULL;
+    arrput(parts, rope->right);
+    arrput(parts, rope->left);
+    while (arrlen(parts) > 0) {
+        Obj* part = arrpop(parts);
+
+        if (part->type == OBJ_ROPE && ((Obj_rope*)part)->flat == NULL) {
+            arrput(parts, ((Obj_rope*)part)->right);
+            arrput(parts, ((Obj_rope*)part)->left);
+            continue;
+        }
+
+        const Obj_string* string = part->type == OBJ_ROPE
+                                     ? ((Obj_rope*)part)->flat
+                                     : (const Obj_string*)part;
+        memcpy(flat->chars + copied, string->chars, string->len);
+        copied += string->len;
+    }
+    arrfree(parts);
+
+    flat->hash = hash_string(flat->chars, flat->len);
+    rope->flat = flat;
+
+    release_obj(rope->left);
+    release_obj(rope->right);
+    rope->left = NULL;
+    rope->right = NULL;
+    return flat;
+}
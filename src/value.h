@@ -0,0 +1,329 @@
+#pragma once
+// clox-basic - C Language Implementation of jlox from Crafting Interpreters.
+//
+// Copyright (C) 2022 Amritpal Singh
+//
+// This file is part of clox-basic.
+//
+// clox-basic is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3
+// of the License, or (at your option) any later version.
+//
+// clox-basic is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied
+// warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// clox-basic. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef CLOX_BASIC_VALUE_H
+#define CLOX_BASIC_VALUE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/* the kinds of objects on the heap */
+enum OBJ_TYPE {
+    /* a string of the intern table, lives as long as the program */
+    OBJ_INTERNED,
+    /* a string made at runtime, freed when its last reference is released */
+    OBJ_STRING,
+    /* a long concatenation, a string whose characters are gathered lazily */
+    OBJ_ROPE
+};
+
+/* every heap object starts with this header, 'refs' counts the references
+ * to objects made at runtime, see retain_value() and release_value() */
+typedef struct Obj {
+    uint8_t type;
+    uint32_t refs;
+} Obj;
+
+/* an immutable, null-terminated string that knows its length and hash */
+typedef struct Obj_string {
+    Obj obj;
+    uint32_t hash;
+    size_t len;
+    char chars[];
+} Obj_string;
+
+/* the concatenation of two strings or ropes, made without copying them.
+ * The characters are gathered into 'flat' the first time they are needed,
+ * the parts are released then */
+typedef struct Obj_rope {
+    Obj obj;
+    size_t len;
+    Obj* left;
+    Obj* right;
+    Obj_string* flat;
+} Obj_rope;
+
+#ifdef CLOX_NAN_BOXING
+
+/* a value packed into the 64 bits of a double. Numbers are stored as they
+ * are, everything else lives in the payload of a quiet NaN which arithmetic
+ * never produces: nil and the booleans as small tags, objects as their
+ * address with the sign bit set. User space addresses fit in 48 bits */
+typedef uint64_t Value;
+
+#define VALUE_SIGN_BIT ((uint64_t)0x8000000000000000)
+#define VALUE_QNAN ((uint64_t)0x7ffc000000000000)
+
+/* the invalid value is the result of a runtime error and
+ * the value of a variable that is not defined yet */
+enum VALUE_TAG { TAG_NIL = 1, TAG_FALSE = 2, TAG_TRUE = 3, TAG_INVALID = 4 };
+
+static inline Value
+number_value(double number)
+{
+    Value value;
+    memcpy(&value, &number, sizeof(Value));
+    return value;
+}
+
+static inline Value
+bool_value(bool boolean)
+{
+    return VALUE_QNAN | (boolean ? TAG_TRUE : TAG_FALSE);
+}
+
+static inline Value
+nil_value(void)
+{
+    return VALUE_QNAN | TAG_NIL;
+}
+
+static inline Value
+invalid_value(void)
+{
+    return VALUE_QNAN | TAG_INVALID;
+}
+
+static inline Value
+obj_value(const Obj* obj)
+{
+    return VALUE_SIGN_BIT | VALUE_QNAN | (uint64_t)(uintptr_t)obj;
+}
+
+static inline bool
+is_number(Value value)
+{
+    return (value & VALUE_QNAN) != VALUE_QNAN;
+}
+
+/* the tags of false and true only differ in the lowest bit */
+static inline bool
+is_bool(Value value)
+{
+    return (value | 1) == bool_value(true);
+}
+
+static inline bool
+is_nil(Value value)
+{
+    return value == nil_value();
+}
+
+static inline bool
+is_invalid(Value value)
+{
+    return value == invalid_value();
+}
+
+static inline bool
+is_obj(Value value)
+{
+    return (value & (VALUE_SIGN_BIT | VALUE_QNAN)) ==
+           (VALUE_SIGN_BIT | VALUE_QNAN);
+}
+
+static inline double
+as_number(Value value)
+{
+    double number;
+    memcpy(&number, &value, sizeof(double));
+    return number;
+}
+
+static inline bool
+as_bool(Value value)
+{
+    return value == bool_value(true);
+}
+
+static inline Obj*
+as_obj(Value value)
+{
+    return (Obj*)(uintptr_t)(value & ~(VALUE_SIGN_BIT | VALUE_QNAN));
+}
+
+#else
+
+enum VALUE_TYPE { VAL_NUMBER, VAL_BOOL, VAL_NIL, VAL_OBJ, VAL_INVALID };
+
+/* a value tagged with its type, for when NaN-boxing is turned off */
+typedef struct {
+    uint8_t type;
+    union {
+        double number;
+        bool boolean;
+        Obj* obj;
+    } as;
+} Value;
+
+static inline Value
+number_value(double number)
+{
+    return (Value){ .type = VAL_NUMBER, .as.number = number };
+}
+
+static inline Value
+bool_value(bool boolean)
+{
+    return (Value){ .type = VAL_BOOL, .as.boolean = boolean };
+}
+
+static inline Value
+nil_value(void)
+{
+    return (Value){ .type = VAL_NIL };
+}
+
+static inline Value
+invalid_value(void)
+{
+    return (Value){ .type = VAL_INVALID };
+}
+
+static inline Value
+obj_value(const Obj* obj)
+{
+    return (Value){ .type = VAL_OBJ, .as.obj = (Obj*)obj };
+}
+
+static inline bool
+is_number(Value value)
+{
+    return value.type == VAL_NUMBER;
+}
+
+static inline bool
+is_bool(Value value)
+{
+    return value.type == VAL_BOOL;
+}
+
+static inline bool
+is_nil(Value value)
+{
+    return value.type == VAL_NIL;
+}
+
+static inline bool
+is_invalid(Value value)
+{
+    return value.type == VAL_INVALID;
+}
+
+static inline bool
+is_obj(Value value)
+{
+    return value.type == VAL_OBJ;
+}
+
+static inline double
+as_number(Value value)
+{
+    return value.as.number;
+}
+
+static inline bool
+as_bool(Value value)
+{
+    return value.as.boolean;
+}
+
+static inline Obj*
+as_obj(Value value)
+{
+    return value.as.obj;
+}
+
+#endif
+
+/* strings and ropes are the only objects */
+static inline bool
+is_string(Value value)
+{
+    return is_obj(value);
+}
+
+/* gather the characters of a rope, once */
+Obj_string*
+flatten_rope(Obj_rope* rope);
+
+/* the characters of a string, a rope is flattened */
+static inline Obj_string*
+as_string(Value value)
+{
+    Obj* obj = as_obj(value);
+    if (obj->type == OBJ_ROPE) return flatten_rope((Obj_rope*)obj);
+
+    return (Obj_string*)obj;
+}
+
+/* the length of a string, without flattening a rope */
+static inline size_t
+string_length(Value value)
+{
+    Obj* obj = as_obj(value);
+    if (obj->type == OBJ_ROPE) return ((Obj_rope*)obj)->len;
+
+    return ((Obj_string*)obj)->len;
+}
+
+/* objects made at runtime are counted, interned strings live forever */
+static inline bool
+is_counted(Value value)
+{
+    return is_obj(value) && as_obj(value)->type != OBJ_INTERNED;
+}
+
+/* take another reference to a value, returns the value */
+static inline Value
+retain_value(Value value)
+{
+    if (is_counted(value)) as_obj(value)->refs++;
+    return value;
+}
+
+/* drop a reference to a value, the object goes with the last one */
+void
+release_value(Value value);
+
+/* room for the text of any number, see format_number() */
+enum { NUMBER_TEXT_SIZE = 32 };
+
+/* write the shortest text that reads back as the number, returns its length */
+size_t
+format_number(double number, char buffer[NUMBER_TEXT_SIZE]);
+
+/* concatenations shorter than this are copied instead of made into a rope */
+enum { ROPE_MIN_LEN = 128 };
+
+/* a new runtime string of two runs of characters, with one reference */
+Obj_string*
+concatenate_chars(const char* left,
+                  size_t left_len,
+                  const char* right,
+                  size_t right_len);
+
+/* a rope of two strings or ropes, it takes over their references */
+Obj_rope*
+make_rope(Obj* left, Obj* right);
+
+#endif
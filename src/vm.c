@@ -0,0 +1,258 @@
+// clox-basic - C Language Implementation of jlox from Crafting Interpreters.
+//
+// Copyright (C) 2022 Amritpal Singh
+//
+// This file is part of clox-basic.
+//
+// clox-basic is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3
+// of the License, or (at your option) any later version.
+//
+// clox-basic is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied
+// warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// clox-basic. If not, see <https://www.gnu.org/licenses/>.
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sysexits.h>
+
+#include "chunk.h"
+#include "compiler.h"
+#include "environment.h"
+#include "evaluator.h"
+#include "program.h"
+#include "resolver.h"
+#include "token.h"
+#include "utility.h"
+#include "value.h"
+#include "vm.h"
+
+/* apply a binary operator to the two values on top of the stack the
+ * way the evaluator does, for the operands without a fast path
+ * Ret:
+ * @Value* : the new top of the stack
+ */
+static Value*
+binary_slow_path(uint8_t op, uint32_t offset, Value* top, bool* had_runtime_error)
+{
+    Value result = binary_operation(op, offset, top[-2], top[-1], had_runtime_error);
+    release_value(top[-2]);
+    release_value(top[-1]);
+    top[-2] = result;
+    return top - 1;
+}
+
+/* the code of a chunk runs until OP_RETURN. Values on the stack are
+ * references the stack owns, like those the evaluator passes around.
+ * Params:
+ * @chunk : the compiled program
+ * @env_mgr : the environments, only the global one is used
+ * @had_runtime_error : set when a runtime error is reported
+ */
+void
+run_chunk(const Chunk* chunk, Env_manager* env_mgr, bool* had_runtime_error)
+{
+    Value* stack = malloc(sizeof(Value) * (chunk->max_stack + 1));
+    if (stack == NULL) {
+        error(NO_SOURCE_OFFSET, "The stack of the virtual machine could not be "
+                                "allocated");
+        exit(EX_OSERR);
+    }
+
+    Value* top = stack;
+    Value* globals = env_mgr->envs[GLOBAL_ENV].values;
+    const uint8_t* code = chunk->code;
+    const uint8_t* ip = code;
+
+#define READ_OPERAND() (ip += OPERAND_SIZE, read_operand(ip - OPERAND_SIZE))
+/* the instructions that can fail have no operands */
+#define SOURCE_OFFSET() (chunk->offsets[ip - 1 - code])
+#define NUMBER_OP(token, result)                                                \
+    do {                                                                        \
+        if (is_number(top[-2]) && is_number(top[-1])) {                         \
+            double a = as_number(top[-2]);                                      \
+            double b = as_number(top[-1]);                                      \
+            top[-2] = (result);                                                 \
+            top--;                                                              \
+        } else {                                                                \
+            top = binary_slow_path(                                             \
+              token, SOURCE_OFFSET(), top, had_runtime_error);                  \
+        }                                                                       \
+    } while (0)
+
+    for (;;) {
+        switch ((enum OPCODE)*ip++) {
+            case OP_CONSTANT:
+                *top++ = retain_value(chunk->constants[READ_OPERAND()]);
+                break;
+            case OP_NIL:
+                *top++ = nil_value();
+                break;
+            case OP_TRUE:
+                *top++ = bool_value(true);
+                break;
+            case OP_FALSE:
+                *top++ = bool_value(false);
+                break;
+            case OP_POP:
+                release_value(*--top);
+                break;
+
+            case OP_GET_GLOBAL:
+                *top++ = retain_value(globals[READ_OPERAND()]);
+                break;
+            case OP_DEFINE_GLOBAL: {
+                Value* variable = &globals[READ_OPERAND()];
+                release_value(*variable);
+                *variable = *--top;
+                break;
+            }
+            case OP_SET_GLOBAL: {
+                Value* variable = &globals[READ_OPERAND()];
+                if (!is_invalid(top[-1])) {
+                    release_value(*variable);
+                    *variable = retain_value(top[-1]);
+                }
+                break;
+            }
+            case OP_GET_LOCAL:
+                *top++ = retain_value(stack[READ_OPERAND()]);
+                break;
+            case OP_DEFINE_LOCAL: {
+                Value* variable = &stack[READ_OPERAND()];
+                release_value(*variable);
+                *variable = *--top;
+                break;
+            }
+            case OP_SET_LOCAL: {
+                Value* variable = &stack[READ_OPERAND()];
+                if (!is_invalid(top[-1])) {
+                    release_value(*variable);
+                    *variable = retain_value(top[-1]);
+                }
+                break;
+            }
+
+            case OP_EQUAL:
+            case OP_NOT_EQUAL: {
+                bool equal = is_equal(top[-2], top[-1]);
+                release_value(top[-2]);
+                release_value(top[-1]);
+                top[-2] = bool_value(ip[-1] == OP_EQUAL ? equal : !equal);
+                top--;
+                break;
+            }
+            case OP_GREATER:
+                NUMBER_OP(GREATER, bool_value(isgreater(a, b)));
+                break;
+            case OP_GREATER_EQUAL:
+                NUMBER_OP(GREATER_EQUAL, bool_value(isgreaterequal(a, b)));
+                break;
+            case OP_LESS:
+                NUMBER_OP(LESS, bool_value(isless(a, b)));
+                break;
+            case OP_LESS_EQUAL:
+                NUMBER_OP(LESS_EQUAL, bool_value(islessequal(a, b)));
+                break;
+            case OP_ADD:
+                NUMBER_OP(PLUS, number_value(a + b));
+                break;
+            case OP_SUBTRACT:
+                NUMBER_OP(MINUS, number_value(a - b));
+                break;
+            case OP_MULTIPLY:
+                NUMBER_OP(STAR, number_value(a * b));
+                break;
+            /* binary_operation() checks the divisor */
+            case OP_DIVIDE:
+                top =
+                  binary_slow_path(SLASH, SOURCE_OFFSET(), top, had_runtime_error);
+                break;
+            case OP_MODULO:
+                top = binary_slow_path(MOD, SOURCE_OFFSET(), top, had_runtime_error);
+                break;
+
+            case OP_NOT: {
+                bool falsy = !is_truthy(top[-1]);
+                release_value(top[-1]);
+                top[-1] = bool_value(falsy);
+                break;
+            }
+            case OP_NEGATE: {
+                if (is_number(top[-1])) {
+                    top[-1] = number_value(-as_number(top[-1]));
+                    break;
+                }
+                Value result = unary_operation(
+                  MINUS, SOURCE_OFFSET(), top[-1], had_runtime_error);
+                release_value(top[-1]);
+                top[-1] = result;
+                break;
+            }
+
+            case OP_PRINT:
+                print_value(top[-1]);
+                release_value(*--top);
+                break;
+
+            case OP_JUMP: {
+                uint32_t distance = READ_OPERAND();
+                ip += distance;
+                break;
+            }
+            case OP_JUMP_IF_FALSE: {
+                uint32_t distance = READ_OPERAND();
+                bool truthy = is_truthy(top[-1]);
+                release_value(*--top);
+                if (!truthy) ip += distance;
+                break;
+            }
+
+            /* every run of a block starts with its locals undefined */
+            case OP_ENTER_BLOCK:
+                for (uint32_t i = READ_OPERAND(); i > 0; i--)
+                    *top++ = invalid_value();
+                break;
+            case OP_EXIT_BLOCK:
+                for (uint32_t i = READ_OPERAND(); i > 0; i--)
+                    release_value(*--top);
+                break;
+
+            case OP_RETURN:
+                free(stack);
+                return;
+        }
+    }
+
+#undef NUMBER_OP
+#undef SOURCE_OFFSET
+#undef READ_OPERAND
+}
+
+void
+interpret_bytecode(Program* program)
+{
+    Chunk chunk = init_chunk();
+
+    if (compile(program, &chunk)) {
+#ifdef CLOX_LOG_ALLOCATIONS
+        printf("Compiled %zu bytes of bytecode with %zu constants\n",
+               arrlenu(chunk.code),
+               arrlenu(chunk.constants));
+#endif
+        reserve_globals(program->env_mgr, hmlenu(program->globals));
+        run_chunk(&chunk, program->env_mgr, &program->had_runtime_error);
+    } else {
+        program->parser->had_error = true;
+    }
+
+    deallocate_chunk(&chunk);
+}
@@ -0,0 +1,38 @@
+#pragma once
+// clox-basic - C Language Implementation of jlox from Crafting Interpreters.
+//
+// Copyright (C) 2022 Amritpal Singh
+//
+// This file is part of clox-basic.
+//
+// clox-basic is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3
+// of the License, or (at your option) any later version.
+//
+// clox-basic is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied
+// warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// clox-basic. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef CLOX_BASIC_VM_H
+#define CLOX_BASIC_VM_H
+
+#include <stdbool.h>
+
+#include "chunk.h"
+#include "program.h"
+
+/* run a compiled chunk, the globals are those of the environment stack
+ * and must have been reserved with reserve_globals() */
+void
+run_chunk(const Chunk* chunk, Env_manager* env_mgr, bool* had_runtime_error);
+
+/* compile a resolved program to bytecode and run it, like interpret() */
+void
+interpret_bytecode(Program* program);
+
+#endif
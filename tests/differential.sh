@@ -0,0 +1,95 @@
+#!/bin/sh
+# clox-basic - C Language Implementation of jlox from Crafting Interpreters.
+#
+# Runs every script with the tree-walking evaluator and with the bytecode
+# virtual machine and fails when their stdout, stderr or exit status differ,
+# or when a sanitizer reports a problem. A script can name the errors it
+# is about in lines of the form "// stderr: <text>", each must be reported.
+# Scripts that run without errors are also run twice from a single parse,
+# which must print their output twice. With --reference the evaluator of
+# a second build, e.g. one without constant folding, must print the same.
+#
+# usage: tests/differential.sh ./clox-basic [--reference ./other] tests/*.lox
+
+bin=$1
+shift
+
+reference=
+if [ "$1" = "--reference" ]; then
+    reference=$2
+    shift 2
+fi
+
+out=$(mktemp -d)
+trap 'rm -rf "$out"' EXIT
+
+failed=0
+for script in "$@"; do
+    "$bin" "$script" </dev/null >"$out/tree.out" 2>"$out/tree.err"
+    echo "exit status $?" >"$out/tree.status"
+    "$bin" --vm "$script" </dev/null >"$out/vm.out" 2>"$out/vm.err"
+    echo "exit status $?" >"$out/vm.status"
+
+    ok=1
+    for part in out err status; do
+        if ! cmp -s "$out/tree.$part" "$out/vm.$part"; then
+            echo "FAIL $script: the $part of the backends differs"
+            diff "$out/tree.$part" "$out/vm.$part" | head -20
+            ok=0
+        fi
+    done
+
+    if [ -n "$reference" ]; then
+        "$reference" "$script" </dev/null >"$out/ref.out" 2>"$out/ref.err"
+        echo "exit status $?" >"$out/ref.status"
+        for part in out err status; do
+            if ! cmp -s "$out/tree.$part" "$out/ref.$part"; then
+                echo "FAIL $script: the $part differs from $reference"
+                diff "$out/ref.$part" "$out/tree.$part" | head -20
+                ok=0
+            fi
+        done
+    fi
+
+    if grep -q -e "Sanitizer" -e "runtime error:" "$out/tree.err" "$out/vm.err"; then
+        echo "FAIL $script: a sanitizer reported a problem"
+        grep -h -e "Sanitizer" -e "runtime error:" "$out/tree.err" "$out/vm.err"
+        ok=0
+    fi
+
+    if [ "$(cat "$out/tree.status")" = "exit status 0" ]; then
+        # the prompt of the REPL that follows the script comes last
+        { head -c -2 "$out/tree.out"; cat "$out/tree.out"; } >"$out/twice"
+        for backend in "" --vm; do
+            "$bin" $backend --runs 2 "$script" </dev/null >"$out/rerun.out" \
+                2>&1
+            if ! cmp -s "$out/twice" "$out/rerun.out"; then
+                again="running it again${backend:+ with $backend}"
+                echo "FAIL $script: $again differs"
+                diff "$out/twice" "$out/rerun.out" | head -20
+                ok=0
+            fi
+        done
+    fi
+
+    expected=$(sed -n 's|^// stderr: ||p' "$script")
+    if [ -n "$expected" ]; then
+        echo "$expected" | while IFS= read -r text; do
+            grep -q -F -e "$text" "$out/tree.err" || echo "$text"
+        done >"$out/missing"
+        if [ -s "$out/missing" ]; then
+            echo "FAIL $script: expected errors were not reported"
+            cat "$out/missing"
+            ok=0
+        fi
+    fi
+
+    if [ $ok -eq 1 ]; then
+        echo "ok   $script"
+    else
+        failed=$((failed + 1))
+    fi
+done
+
+echo "$# scripts, $failed failed"
+[ $failed -eq 0 ]